@@ -1,9 +1,41 @@
 #include <iostream>
+#include <fstream>
 #include <vector>
+#include <array>
+#include <cstdint>
 #include <random>
 #include <algorithm>
-#include <unordered_set>
-#include <set>
+#include <numeric>
+#include <cassert>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <condition_variable>
+#include <list>
+#include <unordered_map>
+#include <type_traits>
+#include <cmath>
+#include <cerrno>
+#include <cstring>
+#include <csignal>
+#include <iomanip>
+#include <sys/resource.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/signalfd.h>
+#include <poll.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FITNESS_SIMD
+#endif
 
 using namespace std;
 
@@ -12,551 +44,3292 @@ constexpr int MAX_REPEATING_RESULT = 300;
 constexpr int CRAZY_MUTATION_INITIAL_PERCENT = 2;
 constexpr int CRAZY_MUTATION_MAXIMUM_PERCENT = 40;
 // const int REMOVE_WORST_PERCENT = 80;
+constexpr int BATCH_CHUNK = 4096;
+// chunks of a batch in memory at once: one being written out, one being solved and one read ahead
+constexpr int BATCH_SLOTS = 3;
+constexpr int MIGRATION_INTERVAL = 50;
+constexpr int MIGRANTS = 5;
+constexpr size_t CHECKED_BOARDS_CAPACITY = 1 << 16;
+// entries of the solution cache when only --cache-file is given
+constexpr size_t SOLUTION_CACHE_CAPACITY = 1 << 16;
+// search nodes the canonical form may take; past them the cache keys the puzzle as it is
+constexpr long long CANONICAL_SEARCH_NODES = 1 << 16;
+// requests of one service client that may be waiting for their answers before its next line is read
+constexpr size_t SERVICE_PIPELINE = 1024;
+// seconds a service request may take when no --time-limit is given, so no puzzle holds a worker for good
+constexpr double SERVICE_TIME_LIMIT = 10;
+// subtrees per thread the solution counter splits a puzzle into when it counts on several threads
+constexpr int COUNT_SUBTREES_PER_THREAD = 16;
+// how often the solvers look at the clock: every that many generations or search nodes
+constexpr int DEADLINE_CHECK_GENERATIONS = 16;
+constexpr int DEADLINE_CHECK_NODES = 1024;
+// the parents and the slots their children are written to
+constexpr int ARENA_SLOTS = POPULATION_SIZE + POPULATION_SIZE / 2;
 
-int crazy_mutation = CRAZY_MUTATION_INITIAL_PERCENT;
+// compile with -DFITNESS_DEBUG to cross-check the incremental fitness against a full recount on every swap
+// compile with -DSOLVER_TRACE to count and time the phases of the solvers, see Trace below
 
-default_random_engine generator;
+#ifdef SOLVER_TRACE
+// timed phases come first, the rest are only counted
+enum Phase {
+    PREPROCESSING, CREATE_POPULATION, MAKE_CHILDREN, REMOVE_DREGS, MIN_FITNESS, CHECK_FINAL, LOCAL_SEARCH, MIGRATION,
+    EXACT_SEARCH, PROPAGATION_PASS, CRAZY_MUTATION, RESTART, PHASE_COUNT
+};
+constexpr int TIMED_PHASES = PROPAGATION_PASS;
+constexpr const char* PHASE_NAMES[PHASE_COUNT] = {
+    "preprocessing", "createPopulation", "makeChildren", "removeDregs", "min_fitness", "check_final", "localSearch",
+    "migrate", "exact search", "propagation pass", "crazy mutation", "restart"
+};
+// events kept per thread for the chrome trace, the counters go on after that
+constexpr size_t TRACE_EVENTS_PER_THREAD = 1 << 20;
 
-int random_number(int a, int b) {
-    uniform_int_distribution<int> distribution(a, b);
-    return distribution(generator);
-}
+// phase counters of all threads, printed to stderr at exit; with --trace FILE the timed phases are also
+// written as a chrome trace (chrome://tracing, perfetto). Every thread writes only to its own buffer
+class Trace {
+private:
+    struct Event {
+        Phase phase;
+        long long start;
+        long long duration;
+    };
+    struct Buffer {
+        int thread = 0;
+        array<long long, PHASE_COUNT> count{};
+        array<long long, PHASE_COUNT> nanoseconds{};
+        vector<Event> events;
+    };
 
-struct VectorHasher {
-    size_t operator()(const vector<vector<int>>& rows) const {
-        size_t hash = 0;
-        for (const auto& row : rows) {
-            for (int val : row) {
-                hash ^= hash * 31 + std::hash<int>{}(val);
-            }
+    mutex m;
+    deque<Buffer> buffers;
+    chrono::steady_clock::time_point origin = chrono::steady_clock::now();
+
+    Buffer& local() {
+        thread_local Buffer* buffer = nullptr;
+        if (!buffer) {
+            lock_guard<mutex> lock(m);
+            buffers.emplace_back();
+            buffer = &buffers.back();
+            buffer->thread = buffers.size();
         }
-        return hash;
+        return *buffer;
     }
-};
 
-class SudokuSolver;
+public:
+    string path;
 
-class SudokuField {
-    friend class SudokuSolver;
-private:
-    vector<vector<int>> rows;
-    vector<vector<int>> grid;
-    vector<unordered_set<int>> allowed_in_row;
-    static unordered_set<vector<vector<int>>, VectorHasher> rows_checked;
-
-    int generate_random(int row_ind) {
-        vector<int> allowed(allowed_in_row[row_ind].begin(), allowed_in_row[row_ind].end());
-        uniform_int_distribution<int> distribution(0, allowed.size() - 1);
-        int chosen = allowed[distribution(generator)];
-        allowed_in_row[row_ind].erase(chosen);
-        return chosen;
+    long long now() const {
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - origin).count();
     }
 
-    void fillInitial() {
-        for (int i = 0; i < 9; ++i) {
-            for (int j = 0; j < 9; ++j) {
-                if (!initial[i][j]) {
-                    int new_num = generate_random(i);
-                    rows[i][j] = new_num;
-                    grid[i / 3 * 3 + j / 3][i % 3 * 3 + j % 3] = new_num;
-                }
+    void count(Phase phase) { ++local().count[phase]; }
+
+    void record(Phase phase, long long start, long long end) {
+        Buffer& buffer = local();
+        ++buffer.count[phase];
+        buffer.nanoseconds[phase] += end - start;
+        if (!path.empty() && buffer.events.size() < TRACE_EVENTS_PER_THREAD) {
+            buffer.events.push_back({phase, start, end - start});
+        }
+    }
+
+    // check_final runs inside min_fitness, so its time is counted in both
+    void summary(ostream& out) {
+        array<long long, PHASE_COUNT> count{}, nanoseconds{};
+        for (const Buffer& buffer : buffers) {
+            for (int p = 0; p < PHASE_COUNT; ++p) {
+                count[p] += buffer.count[p];
+                nanoseconds[p] += buffer.nanoseconds[p];
+            }
+        }
+        out << left << setw(20) << "phase" << right << setw(10) << "count" << setw(14) << "total ms"
+            << setw(10) << "mean us" << endl;
+        for (int p = 0; p < PHASE_COUNT; ++p) {
+            out << left << setw(20) << PHASE_NAMES[p] << right << setw(10) << count[p];
+            if (p < TIMED_PHASES) {
+                out << fixed << setprecision(3) << setw(14) << nanoseconds[p] / 1e6
+                    << setw(10) << (count[p] ? nanoseconds[p] / 1e3 / count[p] : 0.0);
             }
+            out << endl;
         }
     }
 
-    bool rows_correct() const {
-        for (const vector<int>& r : rows) {
-            for (const int& elem : r) {
-                int elem_res = 0;
-                for (const int& el : r) {
-                    if (elem == el) {
-                        elem_res += 1;
-                    }
-                }
-                if (elem_res > 1) {
-                    return false;
-                }
+    void chrome(ostream& out) {
+        out << "{\"traceEvents\": [";
+        bool first = true;
+        for (const Buffer& buffer : buffers) {
+            for (const Event& event : buffer.events) {
+                out << (first ? "\n" : ",\n") << "{\"name\": \"" << PHASE_NAMES[event.phase]
+                    << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer.thread << fixed << setprecision(3)
+                    << ", \"ts\": " << event.start / 1e3 << ", \"dur\": " << event.duration / 1e3 << "}";
+                first = false;
             }
         }
-        return true;
+        out << "\n]}" << endl;
     }
 
-    int computeFitness() const {
-        int f = 0;
-        for (int j = 0; j < 9; ++j) {
-            int count[9] = {0};
-            for (int i = 0; i < 9; ++i) {
-                count[rows[i][j] - 1]++;
-            }
-            for (int k = 0; k < 9; ++k) {
-                if (count[k] > 1) {
-                    f += (count[k] - 1) * count[k];
-                }
+    ~Trace() {
+        summary(cerr);
+        if (path.empty()) return;
+        ofstream file(path);
+        if (file) {
+            chrome(file);
+        } else {
+            cerr << "cannot write " << path << endl;
+        }
+    }
+} TRACE;
+
+// times the rest of the enclosing scope as one phase
+class PhaseScope {
+private:
+    Phase phase;
+    long long start;
+
+public:
+    explicit PhaseScope(Phase p) : phase(p), start(TRACE.now()) {}
+    ~PhaseScope() { TRACE.record(phase, start, TRACE.now()); }
+};
+
+#define TRACE_PHASE(phase) PhaseScope phase_scope(phase)
+#define TRACE_COUNT(phase) TRACE.count(phase)
+#else
+#define TRACE_PHASE(phase)
+#define TRACE_COUNT(phase)
+#endif
+
+// everything is templated on the box size N: a board has N * N rows, columns, boxes and digits.
+// 9x9 is N = 3, 16x16 is N = 4 and 25x25 is N = 5
+template <int N>
+constexpr int SIDE = N * N;
+template <int N>
+constexpr int CELLS = SIDE<N> * SIDE<N>;
+
+// digits 1..SIDE are stored as bits 1..SIDE of the mask
+template <int N>
+using Mask = conditional_t<(SIDE<N> < 16), uint16_t, uint32_t>;
+template <int N>
+constexpr Mask<N> ALL_DIGITS = Mask<N>(((1u << SIDE<N>) - 1) << 1);
+
+template <int N>
+constexpr int box_index(int i, int j) {
+    return i / N * N + j / N;
+}
+
+enum Unit { ROW, COLUMN, BOX };
+
+// cells sharing a row, column or box with a cell, 20 on a 9x9 board
+template <int N>
+constexpr int PEERS = 3 * SIDE<N> - 2 * N - 1;
+
+// index tables built at compile time: row, column and box of every cell,
+// the k-th cell of every row, column and box, and the peers of every cell
+template <int N>
+struct Geometry {
+    uint8_t row[CELLS<N>];
+    uint8_t column[CELLS<N>];
+    uint8_t box[CELLS<N>];
+    uint16_t unit[3][SIDE<N>][SIDE<N>];
+    uint16_t peers[CELLS<N>][PEERS<N>];
+
+    constexpr Geometry() : row(), column(), box(), unit(), peers() {
+        for (int i = 0; i < SIDE<N>; ++i) {
+            for (int j = 0; j < SIDE<N>; ++j) {
+                int c = i * SIDE<N> + j;
+                row[c] = i;
+                column[c] = j;
+                box[c] = box_index<N>(i, j);
             }
         }
-        for (const vector<int>& gr : grid) {
-            int count[9] = {0};
-            for (int i = 0; i < 9; ++i) {
-                count[gr[i] - 1]++;
+        for (int u = 0; u < SIDE<N>; ++u) {
+            for (int k = 0; k < SIDE<N>; ++k) {
+                unit[ROW][u][k] = u * SIDE<N> + k;
+                unit[COLUMN][u][k] = k * SIDE<N> + u;
+                unit[BOX][u][k] = (u / N * N + k / N) * SIDE<N> + u % N * N + k % N;
             }
-            for (int k = 0; k < 9; ++k) {
-                if (count[k] > 1) {
-                    f += (count[k] - 1) * count[k];
-                }
+        }
+        // the rest of the row, the rest of the column, then the cells of the box outside both
+        for (int c = 0; c < CELLS<N>; ++c) {
+            int count = 0;
+            for (int k = 0; k < SIDE<N>; ++k) {
+                if (unit[ROW][row[c]][k] != c) peers[c][count++] = unit[ROW][row[c]][k];
+            }
+            for (int k = 0; k < SIDE<N>; ++k) {
+                if (unit[COLUMN][column[c]][k] != c) peers[c][count++] = unit[COLUMN][column[c]][k];
+            }
+            for (int k = 0; k < SIDE<N>; ++k) {
+                int p = unit[BOX][box[c]][k];
+                if (p / SIDE<N> != row[c] && p % SIDE<N> != column[c]) peers[c][count++] = p;
             }
         }
-        return f * f;
     }
+};
 
-    void swap(int i1, int j1, int i2, int j2) {
-        int num1 = rows[i1][j1];
-        int num2 = rows[i2][j2];
-        rows[i1][j1] = num2;
-        grid[i1 / 3 * 3 + j1 / 3][i1 % 3 * 3 + j1 % 3] = num2;
-        rows[i2][j2] = num1;
-        grid[i2 / 3 * 3 + j2 / 3][i2 % 3 * 3 + j2 % 3] = num1;
-        fitnessValue = computeFitness();
-    }
+template <int N>
+constexpr Geometry<N> GEOMETRY{};
+
+// index of the k-th cell of the u-th row, column or box
+template <int N>
+inline int unit_cell(Unit kind, int u, int k) {
+    return GEOMETRY<N>.unit[kind][u][k];
+}
+
+// digits above 9 are written as letters: 10 is A, 25 is P
+inline char digitChar(int d) {
+    return d < 10 ? '0' + d : 'A' + d - 10;
+}
 
-    void print() const {
-        for (const vector<int>& row : rows) {
-            for (int elem : row) {
-                cout << elem << " ";
+// flat board: cell (i, j) is stored at i * SIDE + j, boxes are derived from the indices
+template <int N>
+struct Board {
+    array<uint8_t, CELLS<N>> cells{};
+
+    uint8_t& at(int i, int j) { return cells[i * SIDE<N> + j]; }
+    uint8_t at(int i, int j) const { return cells[i * SIDE<N> + j]; }
+
+    // k-th cell of the box b
+    uint8_t in_box(int b, int k) const { return cells[unit_cell<N>(BOX, b, k)]; }
+
+    bool operator==(const Board& other) const { return cells == other.cells; }
+};
+
+// Zobrist keys: the hash of a board is the xor of the keys of its (cell, digit) pairs,
+// so a swap updates it with four xors
+template <int N>
+struct ZobristKeys {
+    uint64_t keys[CELLS<N>][SIDE<N> + 1];
+
+    constexpr ZobristKeys() : keys() {
+        uint64_t x = 0x9E3779B97F4A7C15ull;
+        for (int c = 0; c < CELLS<N>; ++c) {
+            for (int d = 0; d <= SIDE<N>; ++d) {
+                // splitmix64
+                uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+                keys[c][d] = z ^ (z >> 31);
             }
-            cout << endl;
         }
     }
+};
 
-protected:
-    static vector<vector<bool>> initial;
-    int fitnessValue;
+template <int N>
+constexpr ZobristKeys<N> ZOBRIST{};
 
-    // constructor for initially creating the field
-    SudokuField(const vector<vector<int>>& r, const vector<vector<int>>& g, const vector<unordered_set<int>>& a) : rows(r), grid(g), allowed_in_row(a) {
-        fillInitial();
-        fitnessValue = computeFitness();
+template <int N>
+uint64_t boardHash(const Board<N>& board) {
+    uint64_t hash = 0;
+    for (int c = 0; c < CELLS<N>; ++c) {
+        hash ^= ZOBRIST<N>.keys[c][board.cells[c]];
     }
+    return hash;
+}
 
-    // constructor for mating and mutations
-    SudokuField(SudokuField& parent1, SudokuField& parent2) {
-        rows = vector<vector<int>>(9, vector<int>(9, 0));
-        grid = vector<vector<int>>(9, vector<int>(9, 0));
-
-        // combining parents (row from one, row from other)
-        bool first = true;
-        for (int i = 0; i < 9; ++i) {
-            for (int j = 0; j < 9; ++j) {
-                int number;
-                if (first) {
-                    number = parent1.rows[i][j];
-                } else {
-                    number = parent2.rows[i][j];
-                }
-                rows[i][j] = number;
-                grid[i / 3 * 3 + j / 3][i % 3 * 3 + j % 3] = number;
+// sum over all columns and boxes of (count - 1) * count for every digit; the fitness is its square
+template <int N>
+int boardConflicts(const Board<N>& board) {
+    int f = 0;
+    for (int j = 0; j < SIDE<N>; ++j) {
+        int count[SIDE<N>] = {0};
+        for (int i = 0; i < SIDE<N>; ++i) {
+            count[board.at(i, j) - 1]++;
+        }
+        for (int k = 0; k < SIDE<N>; ++k) {
+            if (count[k] > 1) {
+                f += (count[k] - 1) * count[k];
             }
-            first = -first;
         }
-
-        // mutation — swapping in row
-        int i = random_number(0, 8);
-        int j_1 = random_number(0, 8);
-        int j_2 = random_number(0, 8);
-        while (initial[i][j_1] || initial[i][j_2] || j_2 == j_1) {
-            i = random_number(0, 8);
-            j_1 = random_number(0, 8);
-            j_2 = random_number(0, 8);
+    }
+    for (int b = 0; b < SIDE<N>; ++b) {
+        int count[SIDE<N>] = {0};
+        for (int k = 0; k < SIDE<N>; ++k) {
+            count[board.in_box(b, k) - 1]++;
         }
-        swap(i, j_1, i, j_2);
-
-        if (random_number(1, 100) <= crazy_mutation) {
-            for (int i = 0; i < 9; ++i) {
-                vector<int> free_js;
-                for (int j = 0; j < 9; ++j) {
-                    if (!initial[i][j]) {
-                        free_js.push_back(j);
-                    }
-                }
-                shuffle(free_js.begin(), free_js.end(), generator);
-                for (int k = 0; k < free_js.size(); k += 2) {
-                    if (k + 1 != free_js.size()) swap(i, free_js[k], i, free_js[k + 1]);
-                }
+        for (int k = 0; k < SIDE<N>; ++k) {
+            if (count[k] > 1) {
+                f += (count[k] - 1) * count[k];
             }
         }
     }
+    return f;
+}
+
+// computes boardConflicts() of count boards at once; all kernels give identical results
+template <int N>
+using ConflictKernel = void (*)(const Board<N>* const* boards, int* conflicts, int count);
+
+template <int N>
+void conflictsScalar(const Board<N>* const* boards, int* conflicts, int count) {
+    for (int k = 0; k < count; ++k) {
+        conflicts[k] = boardConflicts(*boards[k]);
+    }
+}
 
-    bool check_final() {
-        if (fitnessValue == 0) {
-            print();
-            return true;
-        }
-        if (rows_checked.find(rows) != rows_checked.end()) return false;
-        rows_checked.insert(rows);
-        set<pair<int, int>> problems;
+#ifdef FITNESS_SIMD
+// (count - 1) * count summed over the digits of a unit is twice the number of equal pairs of cells in it.
+// The SIMD kernels exist for 9x9 boards only. They keep the nine rows of a board in nine vectors, so lane j of every vector belongs to
+// column j, and shuffle them into nine vectors where lane b of vector k is the k-th cell of box b.
+// Equal pairs are then counted with lane-wise compares, and lanes 9..15 are dropped at the end.
 
-        // searching for conflicts in columns
-        for (int j = 0; j < 9; ++j) {
-            int is[9] = {-1};
-            for (int i = 0; i < 9; ++i) {
-                if (is[rows[i][j] - 1] >= 0 && !initial[i][j] && !initial[is[rows[i][j] - 1]][j]) {
-                    problems.insert({i, j});
-                    problems.insert({is[rows[i][j] - 1], j});
-                }
-                is[rows[i][j] - 1] = i;
-            }
-        }
+// controls moving column 3 * s + u of the t-th row of a box to lane 3 * band + s of box vector 3 * t + u
+struct BoxShuffles {
+    uint8_t control[3][3][16];
 
-        // searching for conflicts in grids
-        for (int i = 0; i < 9; ++i) {
-            for (int j = 0; j < 9; ++j) {
-                for (int is = i / 3 * 3; is < i / 3 * 3 + 1; ++is) {
-                    for (int js = j / 3 * 3; js < j / 3 * 3 + 1; ++js) {
-                        if ((is != i || js != j) && rows[i][j] == rows[is][js] && !initial[i][j] && !initial[is][js]) {
-                            problems.insert({i, j});
-                            problems.insert({is, js});
-                        }
-                    }
+    constexpr BoxShuffles() : control() {
+        for (int band = 0; band < 3; ++band) {
+            for (int u = 0; u < 3; ++u) {
+                for (int lane = 0; lane < 16; ++lane) {
+                    control[band][u][lane] = 0x80;
+                }
+                for (int s = 0; s < 3; ++s) {
+                    control[band][u][band * 3 + s] = s * 3 + u;
                 }
             }
         }
+    }
+};
 
-        vector<pair<int, int>> problems_vec;
-        for (auto& p : problems) {
-            problems_vec.push_back(p);
-        }
+alignas(16) constexpr BoxShuffles BOX_SHUFFLES;
+alignas(16) constexpr uint8_t FIRST_NINE_LANES[16] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
 
-        if (problems_vec.size() < 2) return false;
+__attribute__((target("ssse3")))
+int conflictsSse(const Board<3>& board) {
+    const uint8_t* cells = board.cells.data();
+    __m128i rows[9];
+    for (int r = 0; r < 8; ++r) {
+        rows[r] = _mm_loadu_si128((const __m128i*)(cells + r * 9));
+    }
+    // a full load of the last row would read past the board
+    rows[8] = _mm_srli_si128(_mm_loadu_si128((const __m128i*)(cells + 65)), 7);
 
-        // trying to swap these 4 values by pairs to solve the problem
-        swap(problems_vec[0].first, problems_vec[0].second, problems_vec[1].first, problems_vec[1].second);
-        if (fitnessValue == 0 && rows_correct()) {
-            print();
-            return true;
+    __m128i boxes[9];
+    for (int t = 0; t < 3; ++t) {
+        for (int u = 0; u < 3; ++u) {
+            __m128i v = _mm_setzero_si128();
+            for (int band = 0; band < 3; ++band) {
+                __m128i control = _mm_load_si128((const __m128i*)BOX_SHUFFLES.control[band][u]);
+                v = _mm_or_si128(v, _mm_shuffle_epi8(rows[band * 3 + t], control));
+            }
+            boxes[t * 3 + u] = v;
         }
-        swap(problems_vec[0].first, problems_vec[0].second, problems_vec[1].first, problems_vec[1].second);
-
-        if (problems_vec.size() == 2) return false;
+    }
 
-        swap(problems_vec[0].first, problems_vec[0].second, problems_vec[2].first, problems_vec[2].second);
-        if (fitnessValue == 0 && rows_correct()) {
-            print();
-            return true;
+    __m128i pairs = _mm_setzero_si128();
+    for (int a = 0; a < 9; ++a) {
+        for (int b = a + 1; b < 9; ++b) {
+            pairs = _mm_sub_epi8(pairs, _mm_cmpeq_epi8(rows[a], rows[b]));
+            pairs = _mm_sub_epi8(pairs, _mm_cmpeq_epi8(boxes[a], boxes[b]));
         }
-        swap(problems_vec[0].first, problems_vec[0].second, problems_vec[2].first, problems_vec[2].second);
+    }
+    pairs = _mm_and_si128(pairs, _mm_load_si128((const __m128i*)FIRST_NINE_LANES));
+    __m128i sums = _mm_sad_epu8(pairs, _mm_setzero_si128());
+    return 2 * (_mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums, 4));
+}
 
-        swap(problems_vec[1].first, problems_vec[1].second, problems_vec[2].first, problems_vec[2].second);
-        if (fitnessValue == 0 && rows_correct()) {
-            print();
-            return true;
-        }
-        swap(problems_vec[1].first, problems_vec[1].second, problems_vec[2].first, problems_vec[2].second);
+__attribute__((target("ssse3")))
+void conflictsSseBatch(const Board<3>* const* boards, int* conflicts, int count) {
+    for (int k = 0; k < count; ++k) {
+        conflicts[k] = conflictsSse(*boards[k]);
+    }
+}
 
-        if (problems_vec.size() == 3) return false;
+// 16 bytes of the first board in the low half, the same 16 bytes of the second one in the high half
+__attribute__((target("avx2")))
+inline __m256i loadPair(const uint8_t* first, const uint8_t* second) {
+    __m128i lo = _mm_loadu_si128((const __m128i*)first);
+    __m128i hi = _mm_loadu_si128((const __m128i*)second);
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
 
-        swap(problems_vec[0].first, problems_vec[0].second, problems_vec[3].first, problems_vec[3].second);
-        if (fitnessValue == 0 && rows_correct()) {
-            print();
-            return true;
+// same as conflictsSse, with two boards in the two 128-bit halves of every register
+__attribute__((target("avx2")))
+void conflictsAvx2(const Board<3>* const* boards, int* conflicts, int count) {
+    int k = 0;
+    for (; k + 1 < count; k += 2) {
+        const uint8_t* first = boards[k]->cells.data();
+        const uint8_t* second = boards[k + 1]->cells.data();
+        __m256i rows[9];
+        for (int r = 0; r < 8; ++r) {
+            rows[r] = loadPair(first + r * 9, second + r * 9);
         }
-        swap(problems_vec[0].first, problems_vec[0].second, problems_vec[3].first, problems_vec[3].second);
+        rows[8] = _mm256_srli_si256(loadPair(first + 65, second + 65), 7);
 
-        swap(problems_vec[1].first, problems_vec[1].second, problems_vec[3].first, problems_vec[3].second);
-        if (fitnessValue == 0 && rows_correct()) {
-            print();
-            return true;
+        __m256i boxes[9];
+        for (int t = 0; t < 3; ++t) {
+            for (int u = 0; u < 3; ++u) {
+                __m256i v = _mm256_setzero_si256();
+                for (int band = 0; band < 3; ++band) {
+                    __m256i control = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)BOX_SHUFFLES.control[band][u]));
+                    v = _mm256_or_si256(v, _mm256_shuffle_epi8(rows[band * 3 + t], control));
+                }
+                boxes[t * 3 + u] = v;
+            }
         }
-        swap(problems_vec[1].first, problems_vec[1].second, problems_vec[3].first, problems_vec[3].second);
 
-        swap(problems_vec[2].first, problems_vec[2].second, problems_vec[3].first, problems_vec[3].second);
-        if (fitnessValue == 0 && rows_correct()) {
-            print();
-            return true;
+        __m256i pairs = _mm256_setzero_si256();
+        for (int a = 0; a < 9; ++a) {
+            for (int b = a + 1; b < 9; ++b) {
+                pairs = _mm256_sub_epi8(pairs, _mm256_cmpeq_epi8(rows[a], rows[b]));
+                pairs = _mm256_sub_epi8(pairs, _mm256_cmpeq_epi8(boxes[a], boxes[b]));
+            }
         }
-        swap(problems_vec[2].first, problems_vec[2].second, problems_vec[3].first, problems_vec[3].second);
-
-        cout << "AAAAAAAAAA" << endl;
-        return false;
+        pairs = _mm256_and_si256(pairs, _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)FIRST_NINE_LANES)));
+        __m256i sums = _mm256_sad_epu8(pairs, _mm256_setzero_si256());
+        conflicts[k] = 2 * (_mm256_extract_epi64(sums, 0) + _mm256_extract_epi64(sums, 1));
+        conflicts[k + 1] = 2 * (_mm256_extract_epi64(sums, 2) + _mm256_extract_epi64(sums, 3));
     }
-};
+    if (k < count) {
+        conflicts[k] = conflictsSse(*boards[k]);
+    }
+}
+#endif
 
-class SudokuSolver {
+// the widest kernel the CPU supports, picked once at startup
+template <int N>
+ConflictKernel<N> selectConflictKernel() {
+    return conflictsScalar<N>;
+}
+
+template <>
+ConflictKernel<3> selectConflictKernel<3>() {
+#ifdef FITNESS_SIMD
+    if (__builtin_cpu_supports("avx2")) return conflictsAvx2;
+    if (__builtin_cpu_supports("ssse3")) return conflictsSseBatch;
+#endif
+    return conflictsScalar<3>;
+}
+
+template <int N>
+const ConflictKernel<N> conflictKernel = selectConflictKernel<N>();
+
+// fixed-size set of the board hashes check_final() has already tried; buckets of 4 entries,
+// a full bucket evicts its entries round-robin, nothing is allocated after construction
+class CheckedBoards {
 private:
-    vector<vector<int>> rows;
-    vector<vector<int>> grid;
-    vector<SudokuField> population;
-    vector<unordered_set<int>> allowed_in_row;
-    int unknown_numbers = 0;
+    static constexpr int WAYS = 4;
+    vector<uint64_t> entries;
+    vector<uint8_t> victim;
+    size_t bucket_mask;
 
-    void createPopulation() {
-        population.clear();
-        for (int i = 0; i < POPULATION_SIZE; ++i) {
-            SudokuField field = SudokuField(rows, grid, allowed_in_row);
-            population.push_back(field);
+public:
+    long long lookups = 0;
+    long long hits = 0;
+    long long evictions = 0;
+
+    // the capacity is rounded up to a power of two of at least one bucket
+    explicit CheckedBoards(size_t capacity) {
+        size_t buckets = 1;
+        while (buckets * WAYS < capacity) {
+            buckets *= 2;
         }
+        entries.assign(buckets * WAYS, 0);
+        victim.assign(buckets, 0);
+        bucket_mask = buckets - 1;
     }
 
-    void makeChildren() {
-        shuffle(population.begin(), population.end(), generator);
-        for (int i = 0; i < POPULATION_SIZE; i += 2) {
-            SudokuField kid = SudokuField(population[i], population[i+1]);
-            population.push_back(kid);
+    // true if the hash was not there yet; 0 marks an empty entry, so it is stored as 1
+    bool insert(uint64_t hash) {
+        hash += hash == 0;
+        ++lookups;
+        uint64_t* bucket = &entries[(hash & bucket_mask) * WAYS];
+        for (int w = 0; w < WAYS; ++w) {
+            if (bucket[w] == hash) {
+                ++hits;
+                return false;
+            }
+            if (bucket[w] == 0) {
+                bucket[w] = hash;
+                return true;
+            }
         }
+        uint8_t& v = victim[hash & bucket_mask];
+        bucket[v] = hash;
+        v = (v + 1) % WAYS;
+        ++evictions;
+        return true;
     }
 
-    void removeDregs() {
-        auto ind = population.begin() + POPULATION_SIZE / 2;
-        nth_element(population.begin(), ind, population.end(), [](const SudokuField& a, const SudokuField& b) { return a.fitnessValue > b.fitnessValue; });
-        population.erase(population.begin(), ind);
+    void clear() {
+        fill(entries.begin(), entries.end(), 0);
+        fill(victim.begin(), victim.end(), 0);
+        lookups = hits = evictions = 0;
     }
 
-    int min_fitness() {
-        int minn = __INT_MAX__;
-        for (SudokuField& f : population) {
-            if (f.fitnessValue < minn) {
-                minn = f.fitnessValue;
-                if (minn <= 16 && f.check_final()) {
-                    return 0;
-                }
-            }
-        }
-        return minn;
+    size_t memory() const {
+        return entries.size() * sizeof(uint64_t) + victim.size();
     }
 
-    bool preprocessing_grids() {
-        bool changed = false;
-        vector<vector<set<pair<int, int>>>> info(9, vector<set<pair<int, int>>>(9, set<pair<int, int>>()));
-        for (int i = 0; i < 9; ++i) {
-            for (int j = 0; j < 9; ++j) {
-                if (rows[i][j] == 0) {
-                    for (int num = 0; num < 9; ++num) {
-                        info[i / 3 * 3 + j / 3][num].insert({i, j});
-                    }
+    void report(ostream& out) const {
+        out << "checked boards: " << lookups << " lookups, " << hits << " hits ("
+            << (lookups ? 100 * hits / lookups : 0) << "%), " << evictions << " evictions, "
+            << memory() / 1024 << " KiB" << endl;
+    }
+};
+
+// candidate digits of every cell as bitmasks, kept up to date as digits get placed
+template <int N>
+class SudokuCandidates {
+public:
+    Board<N> board;
+    array<Mask<N>, CELLS<N>> cand;
+    array<Mask<N>, SIDE<N>> row_used{}, col_used{}, box_used{};
+    int unknown_numbers = CELLS<N>;
+    bool givens_conflict = false;
+
+    explicit SudokuCandidates(const Board<N>& b) {
+        cand.fill(ALL_DIGITS<N>);
+        for (int c = 0; c < CELLS<N>; ++c) {
+            if (b.cells[c] != 0) {
+                const Geometry<N>& g = GEOMETRY<N>;
+                if ((row_used[g.row[c]] | col_used[g.column[c]] | box_used[g.box[c]]) & (Mask<N>(1) << b.cells[c])) {
+                    givens_conflict = true;
                 }
+                place(c, b.cells[c]);
             }
         }
-        for (int i = 0; i < 9; ++i) {
-            for (int j = 0; j < 9; ++j) {
-                if (rows[i][j] != 0) {
-                    info[i / 3 * 3 + j / 3][rows[i][j] - 1] = {};
-                    for (int i1 = 0; i1 < 9; i1++) {
-                        info[i1 / 3 * 3 + j / 3][rows[i][j] - 1].erase({i1, j});
-                    }
-                    for (int j1 = 0; j1 < 9; j1++) {
-                        info[i / 3 * 3 + j1 / 3][rows[i][j] - 1].erase({i, j1});
-                    }
-                }
-            }
+    }
+
+    void place(int cell, int num) {
+        const Geometry<N>& g = GEOMETRY<N>;
+        Mask<N> bit = Mask<N>(1) << num;
+        board.cells[cell] = num;
+        cand[cell] = 0;
+        row_used[g.row[cell]] |= bit;
+        col_used[g.column[cell]] |= bit;
+        box_used[g.box[cell]] |= bit;
+        for (int peer : g.peers[cell]) {
+            cand[peer] &= ~bit;
         }
-        for (int gr = 0; gr < 9; ++gr) {
-            for (int num = 0; num < 9; ++num) {
-                if (info[gr][num].size() == 1) {
-                    int x = (*info[gr][num].begin()).first;
-                    int y = (*info[gr][num].begin()).second;
-                    rows[x][y] = num + 1;
-                    grid[x / 3 * 3 + y / 3][x % 3 * 3 + y % 3] = num + 1;
-                    allowed_in_row[x].erase(num + 1);
-                    SudokuField::initial[x][y] = true;
-                    changed = true;
-                    --unknown_numbers;
-                }
+        --unknown_numbers;
+    }
+
+    // cells with only one possible number
+    bool nakedSingles() {
+        bool changed = false;
+        for (int c = 0; c < CELLS<N>; ++c) {
+            if (cand[c] != 0 && (cand[c] & (cand[c] - 1)) == 0) {
+                place(c, __builtin_ctz(cand[c]));
+                changed = true;
             }
         }
         return changed;
     }
 
-    bool preprocessing_rows() {
+    // digits with only one possible cell in the row, column or box
+    bool hiddenSingles(Unit kind) {
         bool changed = false;
-        vector<vector<unordered_set<int>>> info(9, vector<unordered_set<int>>(9, unordered_set<int>()));
-        for (int i = 0; i < 9; ++i) {
-            for (int j = 0; j < 9; ++j) {
-                if (rows[i][j] == 0) {
-                    for (int num = 0; num < 9; ++num) {
-                        info[i][num].insert(j);
-                    }
-                }
+        for (int u = 0; u < SIDE<N>; ++u) {
+            Mask<N> once = 0, twice = 0;
+            for (int k = 0; k < SIDE<N>; ++k) {
+                Mask<N> m = cand[unit_cell<N>(kind, u, k)];
+                twice |= once & m;
+                once |= m;
             }
-        }
-        for (int i = 0; i < 9; ++i) {
-            for (int j = 0; j < 9; ++j) {
-                if (rows[i][j] != 0) {
-                    info[i][rows[i][j] - 1] = {};
-                    for (int i1 = 0; i1 < 9; i1++) {
-                        info[i1][rows[i][j] - 1].erase(j);
-                        for (int j1 = 0; j1 < 9; j1++) {
-                            if (i / 3 * 3 + j / 3 == i1 / 3 * 3 + j1 / 3) {
-                                info[i1][rows[i][j] - 1].erase(j1);
-                            }
-                        }
+            for (Mask<N> singles = once & ~twice; singles; singles &= singles - 1) {
+                int num = __builtin_ctz(singles);
+                for (int k = 0; k < SIDE<N>; ++k) {
+                    int c = unit_cell<N>(kind, u, k);
+                    // an earlier placement in this unit may have taken the cell already
+                    if (cand[c] & (Mask<N>(1) << num)) {
+                        place(c, num);
+                        changed = true;
+                        break;
                     }
                 }
             }
         }
-        for (int row = 0; row < 9; ++row) {
-            for (int num = 0; num < 9; ++num) {
-                if (info[row][num].size() == 1) {
-                    int x = row;
-                    int y = *(info[row][num].begin());
-                    rows[x][y] = num + 1;
-                    grid[x / 3 * 3 + y / 3][x % 3 * 3 + y % 3] = num + 1;
-                    allowed_in_row[x].erase(num + 1);
-                    SudokuField::initial[x][y] = true;
-                    changed = true;
-                    --unknown_numbers;
-                }
-            }
-        }
         return changed;
     }
 
-    bool preprocessing_columns() {
-        bool changed = false;
-        vector<vector<unordered_set<int>>> info(9, vector<unordered_set<int>>(9, unordered_set<int>()));
-        for (int i = 0; i < 9; ++i) {
-            for (int j = 0; j < 9; ++j) {
-                if (rows[i][j] == 0) {
-                    for (int num = 0; num < 9; ++num) {
-                        info[j][num].insert(i);
-                    }
-                }
-            }
+    void propagate() {
+        while (nakedSingles() || hiddenSingles(BOX) || hiddenSingles(ROW) || hiddenSingles(COLUMN)) {
+            TRACE_COUNT(PROPAGATION_PASS);
         }
-        for (int i = 0; i < 9; ++i) {
-            for (int j = 0; j < 9; ++j) {
-                if (rows[i][j] != 0) {
-                    info[j][rows[i][j] - 1] = {};
-                    for (int j1 = 0; j1 < 9; j1++) {
-                        info[j1][rows[i][j] - 1].erase(i);
-                        for (int i1 = 0; i1 < 9; i1++) {
-                            if (i / 3 * 3 + j / 3 == i1 / 3 * 3 + j1 / 3) {
-                                info[j1][rows[i][j] - 1].erase(i1);
-                            }
-                        }
-                    }
+    }
+
+    // the empty cell with the fewest candidates, the one to branch on; two are as few as it gets after propagation
+    int fewestCandidates() const {
+        int best = -1;
+        int best_count = SIDE<N> + 1;
+        for (int c = 0; c < CELLS<N> && best_count > 2; ++c) {
+            if (board.cells[c] == 0) {
+                int count = __builtin_popcount(cand[c]);
+                if (count < best_count) {
+                    best = c;
+                    best_count = count;
                 }
             }
         }
-        for (int col = 0; col < 9; ++col) {
-            for (int num = 0; num < 9; ++num) {
-                if (info[col][num].size() == 1) {
-                    int x = *(info[col][num].begin());
-                    int y = col;
-                    rows[x][y] = num + 1;
-                    grid[x / 3 * 3 + y / 3][x % 3 * 3 + y % 3] = num + 1;
-                    allowed_in_row[x].erase(num + 1);
-                    SudokuField::initial[x][y] = true;
-                    changed = true;
-                    --unknown_numbers;
+        return best;
+    }
+
+    // true if some empty cell has no candidates left or some digit has nowhere to go in a unit
+    bool contradiction() const {
+        if (givens_conflict) return true;
+        for (int c = 0; c < CELLS<N>; ++c) {
+            if (board.cells[c] == 0 && cand[c] == 0) return true;
+        }
+        for (Unit kind : {ROW, COLUMN, BOX}) {
+            for (int u = 0; u < SIDE<N>; ++u) {
+                Mask<N> covered = 0;
+                for (int k = 0; k < SIDE<N>; ++k) {
+                    int c = unit_cell<N>(kind, u, k);
+                    covered |= board.cells[c] ? Mask<N>(1) << board.cells[c] : cand[c];
                 }
+                if (covered != ALL_DIGITS<N>) return true;
             }
         }
-        return changed;
+        return false;
     }
+};
+
+// the hybrid solver is the genetic algorithm with candidate-aware initialization and local search
+enum SolverKind { GENETIC_SOLVER, HYBRID_SOLVER, EXACT_SOLVER };
+
+constexpr const char* SOLVER_NAMES[] = {"ga", "hybrid", "dfs"};
+
+enum SolveStatus { SOLVED, UNSOLVABLE, TIMED_OUT };
+
+// run settings passed from main() down to the solvers
+struct SolverOptions {
+    SolverKind kind = EXACT_SOLVER;
+    bool verbose = false;
+    unsigned seed = default_random_engine::default_seed;
+    // threads working on one puzzle as islands of the genetic algorithm
+    int islands = 1;
+    size_t checked_boards = CHECKED_BOARDS_CAPACITY;
+    // budget of one puzzle in seconds and in generations of every island, 0 for none
+    double time_limit = 0;
+    long long generation_limit = 0;
+    // no solver runs past it, whatever the budget of the puzzle; a batch sets it for all its puzzles
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max();
+};
+
+// work a solver did on one puzzle, reported by the benchmark
+struct SolveStats {
+    long long generations = 0;
+    // populations recreated from scratch after the crazy mutation did not help
+    int restarts = 0;
+    // search nodes of the exact solver
+    long long nodes = 0;
+    // fitness of the best board of a genetic run that timed out, -1 when there is no complete board
+    int fitness = -1;
+};
+
+// xoshiro256** seeded through splitmix64: a handful of shifts, xors and one multiplication per draw
+class Xoshiro256 {
+private:
+    uint64_t state[4];
+
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
 
 public:
-    SudokuSolver(vector<vector<int>>& r, vector<vector<int>>& g, vector<unordered_set<int>>& a) : rows(r), grid(g), allowed_in_row(a) {
-        vector<vector<bool>> initial = vector<vector<bool>>(9, vector<bool>(9, true));
-        for (int i = 0; i < 9; ++i) {
-            for (int j = 0; j < 9; ++j) {
-                if (rows[i][j] == 0) {
-                    initial[i][j] = false;
-                    ++unknown_numbers;
-                }
-            }
+    typedef uint64_t result_type;
+
+    explicit Xoshiro256(uint64_t seed) {
+        for (uint64_t& s : state) {
+            uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            s = z ^ (z >> 31);
         }
-        SudokuField::initial = initial;
     }
 
-    void solve() {
-        int iters_without_changing = 0;
-        int current_fitness = 0;
-        while (preprocessing_grids() || preprocessing_rows() || preprocessing_columns()) {}
-        createPopulation();
-        if (unknown_numbers == 0) {
-            for (const vector<int>& row : rows) {
-                for (int elem : row) {
-                    cout << elem << " ";
-                }
-                cout << endl;
+    static constexpr uint64_t min() { return 0; }
+    static constexpr uint64_t max() { return UINT64_MAX; }
+
+    uint64_t operator()() {
+        uint64_t result = rotl(state[1] * 5, 7) * 9;
+        uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
+
+    // uniform in [0, n) without bias: the high half of a 32x32-bit product, redrawn in the rare biased cases
+    uint32_t below(uint32_t n) {
+        uint64_t m = ((*this)() >> 32) * n;
+        if (uint32_t(m) < n) {
+            uint32_t threshold = -n % n;
+            while (uint32_t(m) < threshold) {
+                m = ((*this)() >> 32) * n;
             }
-            return;
         }
-        while (true) {
-            makeChildren();  // спаривание + мутации
-            removeDregs();   // сортировка и удаление худших
+        return m >> 32;
+    }
+};
 
-            int min_fit = min_fitness();
-            if (min_fit == 0) {
-                return;
-            } else if (current_fitness == min_fit) {
-                iters_without_changing++;
-            } else {
-                cout << min_fit << endl;
-                current_fitness = min_fit;
-                crazy_mutation = CRAZY_MUTATION_INITIAL_PERCENT;
-                iters_without_changing = 0;
-            }
-            if (iters_without_changing >= MAX_REPEATING_RESULT) {
-                if (crazy_mutation == CRAZY_MUTATION_INITIAL_PERCENT) {
-                    crazy_mutation = CRAZY_MUTATION_MAXIMUM_PERCENT;
-                } else {
-                    crazy_mutation = CRAZY_MUTATION_INITIAL_PERCENT;
-                    createPopulation();
+// everything a genetic run mutates besides its population; every SudokuSolver owns one,
+// so solvers running on different threads never share state
+template <int N>
+struct GeneticContext {
+    Xoshiro256 generator;
+    int crazy_mutation = CRAZY_MUTATION_INITIAL_PERCENT;
+    array<bool, CELLS<N>> initial{};
+    // the free columns of every row, and every pair of free cells sharing a row, so a mutation is one draw
+    array<array<uint8_t, SIDE<N>>, SIDE<N>> free_columns{};
+    array<uint8_t, SIDE<N>> free_count{};
+    vector<pair<uint16_t, uint16_t>> free_pairs;
+    // hybrid solver: the candidates left by the preprocessing, and the free columns of every row
+    // ordered by their number of candidates, the order the initialization fills them in
+    array<Mask<N>, CELLS<N>> candidates{};
+    array<array<uint8_t, SIDE<N>>, SIDE<N>> fill_order{};
+    CheckedBoards rows_checked;
+
+    explicit GeneticContext(const SolverOptions& options)
+        : generator(options.seed), rows_checked(options.checked_boards) {
+        free_pairs.reserve(SIDE<N> * SIDE<N> * (SIDE<N> - 1) / 2);
+    }
+
+    // the cells the preprocessing filled stay fixed, the others are free for the mutations
+    void markGivens(const SudokuCandidates<N>& preprocessed) {
+        const Board<N>& board = preprocessed.board;
+        candidates = preprocessed.cand;
+        free_pairs.clear();
+        for (int i = 0; i < SIDE<N>; ++i) {
+            free_count[i] = 0;
+            for (int j = 0; j < SIDE<N>; ++j) {
+                int c = i * SIDE<N> + j;
+                initial[c] = board.cells[c] != 0;
+                if (initial[c]) continue;
+                for (int k = 0; k < free_count[i]; ++k) {
+                    free_pairs.push_back({i * SIDE<N> + free_columns[i][k], c});
                 }
-                iters_without_changing = 0;
+                free_columns[i][free_count[i]++] = j;
             }
+            fill_order[i] = free_columns[i];
+            stable_sort(fill_order[i].begin(), fill_order[i].begin() + free_count[i], [&](int a, int b) {
+                return __builtin_popcount(candidates[i * SIDE<N> + a]) < __builtin_popcount(candidates[i * SIDE<N> + b]);
+            });
+        }
+    }
+
+    int random_number(int a, int b) {
+        return a + generator.below(b - a + 1);
+    }
+
+    template <class T>
+    void shuffle(T* first, T* last) {
+        for (int k = last - first - 1; k > 0; --k) {
+            std::swap(first[k], first[generator.below(k + 1)]);
         }
     }
 };
 
-vector<vector<bool>> SudokuField::initial(1, vector<bool>(1, false));
-unordered_set<vector<vector<int>>, VectorHasher> SudokuField::rows_checked;
-
-int main() {
-    freopen("input.txt", "r", stdin);
-    // freopen("output.txt", "w", stdout);
-
-    // preparing to handle hyphen instead of number
-    cin.exceptions(ios::failbit);
-    
-    // input processing
-    vector<vector<int>> rows(9, vector<int>(9, 0)), grid(9, vector<int>(9, 0));
-    vector<unordered_set<int>> allowed_in_row(9, {1, 2, 3, 4, 5, 6, 7, 8, 9});
-    vector<vector<unordered_set<int>>> possible(9, vector<unordered_set<int>>(9, {1, 2, 3, 4, 5, 6, 7, 8, 9}));
-    
-    for (int i = 0; i < 9; ++i) {
-        for (int j = 0; j < 9; ++j) {
-            try {
-                int num;
-                cin >> num;
-                rows[i][j] = num;
-                grid[i / 3 * 3 + j / 3][i % 3 * 3 + j % 3] = num;
-                allowed_in_row[i].erase(num);
-
-                // detect if there is a cell with only one possible number
-                for (int i1 = 0; i1 < 9; ++i1) {
-                    for (int j1 = 0; j1 < 9; ++j1) {
-                        if ((i == i1 || j == j1 || i / 3 * 3 + j / 3 == i1 / 3 * 3 + j1 / 3) && !(i == i1 && j == j1)) {
-                            possible[i1][j1].erase(num);
-                            if (possible[i1][j1].size() == 1) {
-                                int num1 = *(possible[i1][j1].begin());
-                                rows[i1][j1] = num1;
-                                grid[i1 / 3 * 3 + j1 / 3][i1 % 3 * 3 + j1 % 3] = num1;
-                                allowed_in_row[i1].erase(num1);
-                            }
-                        }
-                    }
+// how many times each digit occurs in every column or every box, index is unit * SIDE + digit - 1
+template <int N>
+using DigitCounts = array<uint8_t, CELLS<N>>;
+
+// the fields of a population stored as parallel arrays; a field is a slot index into all of them,
+// so selection only moves slot indices around and a generation allocates nothing
+template <int N>
+struct FieldArena {
+    vector<Board<N>> boards;
+    vector<DigitCounts<N>> col_counts;
+    vector<DigitCounts<N>> box_counts;
+    vector<int> conflicts;
+    vector<int> fitness;
+    vector<uint64_t> hashes;
+
+    explicit FieldArena(int slots)
+        : boards(slots), col_counts(slots), box_counts(slots), conflicts(slots), fitness(slots), hashes(slots) {}
+};
+
+template <int N>
+class SudokuSolver;
+
+// view of one slot of a FieldArena
+template <int N>
+class SudokuField {
+    friend class SudokuSolver<N>;
+private:
+    Board<N>& board;
+    DigitCounts<N>& col_count;
+    DigitCounts<N>& box_count;
+    int& conflicts;
+    uint64_t& hash;
+
+    // takes a random digit out of the mask of still unused digits
+    static int generate_random(GeneticContext<N>& context, Mask<N>& allowed) {
+        int k = context.random_number(0, __builtin_popcount(allowed) - 1);
+        Mask<N> rest = allowed;
+        while (k--) {
+            rest &= rest - 1;
+        }
+        int chosen = __builtin_ctz(rest);
+        allowed &= ~(Mask<N>(1) << chosen);
+        return chosen;
+    }
+
+    void fillInitial(GeneticContext<N>& context, array<Mask<N>, SIDE<N>> allowed_in_row) {
+        for (int i = 0; i < SIDE<N>; ++i) {
+            for (int j = 0; j < SIDE<N>; ++j) {
+                if (!context.initial[i * SIDE<N> + j]) {
+                    board.at(i, j) = generate_random(context, allowed_in_row[i]);
                 }
-            } catch (const ios_base::failure& e) {
-                // handling hyphen instead of number
-                cin.clear(); 
             }
         }
     }
-    fclose(stdin);
 
-    // creating the class instance, solving, and printing
-    SudokuSolver sudoku = SudokuSolver(rows, grid, allowed_in_row);
-    sudoku.solve();
-    // fclose(stdout);
+    // rows are still permutations, but every cell prefers a digit that is a candidate of the cell and not
+    // yet in its column or box, then any candidate, then whatever digit the row has left
+    void fillCandidates(GeneticContext<N>& context, const array<Mask<N>, SIDE<N>>& allowed_in_row) {
+        const Geometry<N>& g = GEOMETRY<N>;
+        array<Mask<N>, SIDE<N>> col_used{}, box_used{};
+        for (int c = 0; c < CELLS<N>; ++c) {
+            if (context.initial[c]) {
+                col_used[g.column[c]] |= Mask<N>(1) << board.cells[c];
+                box_used[g.box[c]] |= Mask<N>(1) << board.cells[c];
+            }
+        }
+        for (int i = 0; i < SIDE<N>; ++i) {
+            Mask<N> remaining = allowed_in_row[i];
+            for (int k = 0; k < context.free_count[i]; ++k) {
+                int j = context.fill_order[i][k];
+                int c = i * SIDE<N> + j;
+                Mask<N> options = remaining & context.candidates[c];
+                if (options & ~(col_used[j] | box_used[g.box[c]])) {
+                    options &= ~(col_used[j] | box_used[g.box[c]]);
+                } else if (options == 0) {
+                    options = remaining;
+                }
+                int d = generate_random(context, options);
+                remaining &= ~(Mask<N>(1) << d);
+                board.cells[c] = d;
+                col_used[j] |= Mask<N>(1) << d;
+                box_used[g.box[c]] |= Mask<N>(1) << d;
+            }
+        }
+    }
+
+    bool rows_correct() const {
+        for (int i = 0; i < SIDE<N>; ++i) {
+            Mask<N> seen = 0;
+            for (int j = 0; j < SIDE<N>; ++j) {
+                Mask<N> bit = Mask<N>(1) << board.at(i, j);
+                if (seen & bit) {
+                    return false;
+                }
+                seen |= bit;
+            }
+        }
+        return true;
+    }
+
+    int computeFitness() const {
+        int f = boardConflicts(board);
+        return f * f;
+    }
+
+    // moving a digit in or out of a unit with n copies changes (n - 1) * n by 2 * n or 2 * (n - 1)
+    void addDigit(int cell, int d) {
+        conflicts += 2 * col_count[GEOMETRY<N>.column[cell] * SIDE<N> + d - 1]++;
+        conflicts += 2 * box_count[GEOMETRY<N>.box[cell] * SIDE<N> + d - 1]++;
+    }
+
+    void removeDigit(int cell, int d) {
+        conflicts -= 2 * --col_count[GEOMETRY<N>.column[cell] * SIDE<N> + d - 1];
+        conflicts -= 2 * --box_count[GEOMETRY<N>.box[cell] * SIDE<N> + d - 1];
+    }
+
+    // builds the per-column and per-box digit counts from scratch
+    void countDigits() {
+        col_count.fill(0);
+        box_count.fill(0);
+        conflicts = 0;
+        for (int c = 0; c < CELLS<N>; ++c) {
+            addDigit(c, board.cells[c]);
+        }
+        fitnessValue = conflicts * conflicts;
+    }
+
+    void swap(int c1, int c2) {
+        int num1 = board.cells[c1];
+        int num2 = board.cells[c2];
+        if (num1 == num2) return;
+        removeDigit(c1, num1);
+        removeDigit(c2, num2);
+        board.cells[c1] = num2;
+        board.cells[c2] = num1;
+        addDigit(c1, num2);
+        addDigit(c2, num1);
+        fitnessValue = conflicts * conflicts;
+        hash ^= ZOBRIST<N>.keys[c1][num1] ^ ZOBRIST<N>.keys[c1][num2]
+              ^ ZOBRIST<N>.keys[c2][num2] ^ ZOBRIST<N>.keys[c2][num1];
+#ifdef FITNESS_DEBUG
+        assert(fitnessValue == computeFitness());
+        assert(hash == boardHash(board));
+#endif
+    }
+
+protected:
+    int& fitnessValue;
+
+    SudokuField(FieldArena<N>& arena, int slot)
+        : board(arena.boards[slot]), col_count(arena.col_counts[slot]), box_count(arena.box_counts[slot]),
+          conflicts(arena.conflicts[slot]), hash(arena.hashes[slot]), fitnessValue(arena.fitness[slot]) {}
+
+    // digit counts, fitness and hash from scratch; the batch evaluation of new fields only fills in
+    // the fitness, the rest is needed once the field gets repaired or migrates
+    void rebuild() {
+        countDigits();
+        hash = boardHash(board);
+    }
+
+    // swapping two cells of a field whose fitness is evaluated afterwards
+    void exchange(int c1, int c2) {
+        std::swap(board.cells[c1], board.cells[c2]);
+    }
+
+    // initially creating the field, its fitness is evaluated afterwards
+    void create(GeneticContext<N>& context, const Board<N>& b, const array<Mask<N>, SIDE<N>>& allowed_in_row, bool hybrid) {
+        board = b;
+        if (hybrid) {
+            fillCandidates(context, allowed_in_row);
+        } else {
+            fillInitial(context, allowed_in_row);
+        }
+    }
+
+    // column and sub-block local search after Wang et al.: two free cells of a row swap their digits when
+    // both are repeated in their columns (or boxes) and neither digit is in the other's column (or box) yet;
+    // a swap that raises the conflicts over all columns and boxes is undone. Needs the digit counts
+    void localSearch(GeneticContext<N>& context) {
+        TRACE_PHASE(LOCAL_SEARCH);
+        const Geometry<N>& g = GEOMETRY<N>;
+        for (int i = 0; i < SIDE<N>; ++i) {
+            // only cells repeated in their column or box can take part in a swap
+            int repeated[SIDE<N>];
+            int count = 0;
+            for (int k = 0; k < context.free_count[i]; ++k) {
+                int c = i * SIDE<N> + context.free_columns[i][k];
+                int d = board.cells[c] - 1;
+                if (col_count[g.column[c] * SIDE<N> + d] > 1 || box_count[g.box[c] * SIDE<N> + d] > 1) {
+                    repeated[count++] = c;
+                }
+            }
+            for (int x = 0; x < count; ++x) {
+                for (int y = x + 1; y < count; ++y) {
+                    int c1 = repeated[x], c2 = repeated[y];
+                    int a = board.cells[c1] - 1, b = board.cells[c2] - 1;
+                    int col1 = g.column[c1] * SIDE<N>, col2 = g.column[c2] * SIDE<N>;
+                    int box1 = g.box[c1] * SIDE<N>, box2 = g.box[c2] * SIDE<N>;
+                    bool columns = col_count[col1 + a] > 1 && col_count[col2 + b] > 1
+                                && col_count[col1 + b] == 0 && col_count[col2 + a] == 0;
+                    bool boxes = box1 != box2 && box_count[box1 + a] > 1 && box_count[box2 + b] > 1
+                              && box_count[box1 + b] == 0 && box_count[box2 + a] == 0;
+                    if (!columns && !boxes) continue;
+                    int before = conflicts;
+                    swap(c1, c2);
+                    if (conflicts > before) {
+                        swap(c1, c2);
+                    }
+                }
+            }
+        }
+    }
+
+    // mating and mutations, the fitness is evaluated afterwards
+    void mate(GeneticContext<N>& context, const Board<N>& parent1, const Board<N>& parent2) {
+        // combining parents (row from one, row from other)
+        bool first = true;
+        for (int i = 0; i < SIDE<N>; ++i) {
+            const Board<N>& parent = first ? parent1 : parent2;
+            copy_n(parent.cells.begin() + i * SIDE<N>, SIDE<N>, board.cells.begin() + i * SIDE<N>);
+            first = -first;
+        }
+
+        // mutation — swapping in row, uniform over the pairs of free cells sharing a row
+        if (!context.free_pairs.empty()) {
+            auto [c1, c2] = context.free_pairs[context.random_number(0, context.free_pairs.size() - 1)];
+            exchange(c1, c2);
+        }
+
+        if (context.random_number(1, 100) <= context.crazy_mutation) {
+            for (int i = 0; i < SIDE<N>; ++i) {
+                int free_count = context.free_count[i];
+                uint8_t free_js[SIDE<N>];
+                copy_n(context.free_columns[i].begin(), free_count, free_js);
+                context.shuffle(free_js, free_js + free_count);
+                for (int k = 0; k + 1 < free_count; k += 2) {
+                    exchange(i * SIDE<N> + free_js[k], i * SIDE<N> + free_js[k + 1]);
+                }
+            }
+        }
+    }
+
+    bool check_final(GeneticContext<N>& context) {
+        TRACE_PHASE(CHECK_FINAL);
+        if (fitnessValue == 0) {
+            return true;
+        }
+        rebuild();
+        if (!context.rows_checked.insert(hash)) return false;
+        array<bool, CELLS<N>> problems{};
+
+        // searching for conflicts in columns
+        for (int j = 0; j < SIDE<N>; ++j) {
+            int is[SIDE<N>] = {-1};
+            for (int i = 0; i < SIDE<N>; ++i) {
+                int d = board.at(i, j) - 1;
+                if (is[d] >= 0 && !context.initial[i * SIDE<N> + j] && !context.initial[is[d] * SIDE<N> + j]) {
+                    problems[i * SIDE<N> + j] = true;
+                    problems[is[d] * SIDE<N> + j] = true;
+                }
+                is[d] = i;
+            }
+        }
+
+        // searching for conflicts in grids: every cell is compared with the first cell of its box only
+        for (int c = 0; c < CELLS<N>; ++c) {
+            int first = GEOMETRY<N>.unit[BOX][GEOMETRY<N>.box[c]][0];
+            if (c != first && board.cells[c] == board.cells[first] && !context.initial[c] && !context.initial[first]) {
+                problems[c] = true;
+                problems[first] = true;
+            }
+        }
+
+        // only the first four problem cells are ever tried
+        int problems_vec[4];
+        int problems_count = 0;
+        for (int c = 0; c < CELLS<N> && problems_count < 4; ++c) {
+            if (problems[c]) {
+                problems_vec[problems_count++] = c;
+            }
+        }
+
+        if (problems_count < 2) return false;
+
+        // trying to swap these 4 values by pairs to solve the problem
+        swap(problems_vec[0], problems_vec[1]);
+        if (fitnessValue == 0 && rows_correct()) {
+            return true;
+        }
+        swap(problems_vec[0], problems_vec[1]);
+
+        if (problems_count == 2) return false;
+
+        swap(problems_vec[0], problems_vec[2]);
+        if (fitnessValue == 0 && rows_correct()) {
+            return true;
+        }
+        swap(problems_vec[0], problems_vec[2]);
+
+        swap(problems_vec[1], problems_vec[2]);
+        if (fitnessValue == 0 && rows_correct()) {
+            return true;
+        }
+        swap(problems_vec[1], problems_vec[2]);
+
+        if (problems_count == 3) return false;
+
+        swap(problems_vec[0], problems_vec[3]);
+        if (fitnessValue == 0 && rows_correct()) {
+            return true;
+        }
+        swap(problems_vec[0], problems_vec[3]);
+
+        swap(problems_vec[1], problems_vec[3]);
+        if (fitnessValue == 0 && rows_correct()) {
+            return true;
+        }
+        swap(problems_vec[1], problems_vec[3]);
+
+        swap(problems_vec[2], problems_vec[3]);
+        if (fitnessValue == 0 && rows_correct()) {
+            return true;
+        }
+        swap(problems_vec[2], problems_vec[3]);
+
+        return false;
+    }
+};
+
+// the islands of the parallel genetic algorithm for one puzzle: every island periodically sends copies
+// of its best fields to the next island of the ring, and the first island to solve the puzzle stops the rest
+template <int N>
+class Archipelago {
+private:
+    struct alignas(64) Inbox {
+        mutex m;
+        vector<Board<N>> boards;
+    };
+    vector<Inbox> inboxes;
+
+public:
+    atomic<bool> solved{false};
+    Board<N> solution;
+
+    explicit Archipelago(int islands) : inboxes(islands) {}
+
+    int size() const { return inboxes.size(); }
+
+    // migrants that were not picked up yet are replaced by the newer ones
+    void send(int island, const vector<Board<N>>& boards) {
+        lock_guard<mutex> lock(inboxes[island].m);
+        inboxes[island].boards.assign(boards.begin(), boards.end());
+    }
+
+    void receive(int island, vector<Board<N>>& boards) {
+        boards.clear();
+        lock_guard<mutex> lock(inboxes[island].m);
+        boards.swap(inboxes[island].boards);
+    }
+
+    // only the first island to finish gets to store its solution
+    void finish(const Board<N>& board) {
+        bool expected = false;
+        if (solved.compare_exchange_strong(expected, true)) {
+            solution = board;
+        }
+    }
+};
+
+template <int N>
+class SudokuSolver {
+private:
+    SudokuCandidates<N> candidates;
+    GeneticContext<N> context;
+    Board<N> board;
+    FieldArena<N> arena;
+    // slots of the arena: members[0, POPULATION_SIZE) hold the parents, the rest receive the children
+    array<int, ARENA_SLOTS> members;
+    array<Mask<N>, SIDE<N>> allowed_in_row;
+    int unknown_numbers = 0;
+    bool verbose;
+    Board<N> solution;
+    Archipelago<N>* archipelago;
+    int island;
+    vector<Board<N>> outgoing;
+    vector<Board<N>> migrants;
+    bool hybrid;
+    SolveStats stats;
+    chrono::steady_clock::time_point deadline;
+    long long generation_limit;
+    // slot of the best field found by the last min_fitness()
+    int best_slot = 0;
+
+    // fixes every digit the candidate engine can deduce before the genetic part starts
+    void preprocessing() {
+        TRACE_PHASE(PREPROCESSING);
+        candidates.propagate();
+        board = candidates.board;
+        unknown_numbers = candidates.unknown_numbers;
+        for (int i = 0; i < SIDE<N>; ++i) {
+            allowed_in_row[i] = ALL_DIGITS<N> & ~candidates.row_used[i];
+        }
+        context.markGivens(candidates);
+    }
+
+    bool fitter(int a, int b) const {
+        return arena.fitness[a] < arena.fitness[b];
+    }
+
+    // fitness of the fields in the given slots, computed by the conflict kernel in one batch
+    void evaluate(const int* slots, int count) {
+        array<const Board<N>*, ARENA_SLOTS> boards{};
+        array<int, ARENA_SLOTS> conflicts;
+        for (int k = 0; k < count; ++k) {
+            boards[k] = &arena.boards[slots[k]];
+        }
+        conflictKernel<N>(boards.data(), conflicts.data(), count);
+        for (int k = 0; k < count; ++k) {
+#ifdef FITNESS_DEBUG
+            assert(conflicts[k] == boardConflicts(*boards[k]));
+#endif
+            arena.conflicts[slots[k]] = conflicts[k];
+            arena.fitness[slots[k]] = conflicts[k] * conflicts[k];
+        }
+    }
+
+    // the hybrid solver counts the digits of every new field for the local search, which leaves
+    // the fitness known; the plain genetic algorithm evaluates all new fields in one batch
+    void improve(int slot) {
+        SudokuField<N> field = SudokuField<N>(arena, slot);
+        field.rebuild();
+        field.localSearch(context);
+    }
+
+    void createPopulation() {
+        TRACE_PHASE(CREATE_POPULATION);
+        for (int i = 0; i < POPULATION_SIZE; ++i) {
+            SudokuField<N>(arena, members[i]).create(context, board, allowed_in_row, hybrid);
+            if (hybrid) improve(members[i]);
+        }
+        if (!hybrid) evaluate(members.data(), POPULATION_SIZE);
+    }
+
+    void makeChildren() {
+        TRACE_PHASE(MAKE_CHILDREN);
+        context.shuffle(members.data(), members.data() + POPULATION_SIZE);
+        for (int i = 0; i < POPULATION_SIZE; i += 2) {
+            SudokuField<N> kid = SudokuField<N>(arena, members[POPULATION_SIZE + i / 2]);
+            kid.mate(context, arena.boards[members[i]], arena.boards[members[i + 1]]);
+            if (hybrid) improve(members[POPULATION_SIZE + i / 2]);
+        }
+        if (!hybrid) evaluate(members.data() + POPULATION_SIZE, ARENA_SLOTS - POPULATION_SIZE);
+    }
+
+    // the worst slots end up behind the parents and are overwritten by the next children
+    void removeDregs() {
+        TRACE_PHASE(REMOVE_DREGS);
+        nth_element(members.begin(), members.begin() + POPULATION_SIZE, members.end(),
+                    [this](int a, int b) { return fitter(a, b); });
+    }
+
+    int min_fitness() {
+        TRACE_PHASE(MIN_FITNESS);
+        int minn = __INT_MAX__;
+        for (int i = 0; i < POPULATION_SIZE; ++i) {
+            int slot = members[i];
+            if (arena.fitness[slot] < minn) {
+                minn = arena.fitness[slot];
+                best_slot = slot;
+                // the local search has already tried the repairs check_final() would
+                if (hybrid ? minn == 0 : minn <= 16 && SudokuField<N>(arena, slot).check_final(context)) {
+                    solution = arena.boards[slot];
+                    return 0;
+                }
+            }
+        }
+        return minn;
+    }
+
+    // sends the best fields to the next island and lets the received ones replace the worst
+    void migrate() {
+        TRACE_PHASE(MIGRATION);
+        auto by_fitness = [this](int a, int b) { return fitter(a, b); };
+        auto parents_end = members.begin() + POPULATION_SIZE;
+        auto best = members.begin() + MIGRANTS;
+        nth_element(members.begin(), best, parents_end, by_fitness);
+        outgoing.clear();
+        for (auto it = members.begin(); it != best; ++it) {
+            outgoing.push_back(arena.boards[*it]);
+        }
+        archipelago->send((island + 1) % archipelago->size(), outgoing);
+
+        archipelago->receive(island, migrants);
+        int n = min<int>(migrants.size(), parents_end - best);
+        auto worst = parents_end - n;
+        nth_element(best, worst, parents_end, by_fitness);
+        for (int k = 0; k < n; ++k) {
+            arena.boards[worst[k]] = migrants[k];
+            SudokuField<N>(arena, worst[k]).rebuild();
+        }
+    }
+
+    SolveStatus finish() {
+        if (archipelago) archipelago->finish(solution);
+        if (verbose) context.rows_checked.report(cerr);
+        stats.fitness = 0;
+        return SOLVED;
+    }
+
+    // the clock is read on the first generation, so a puzzle started past the deadline stops at once,
+    // and then only every few generations, a generation takes microseconds
+    bool outOfBudget(int generation) const {
+        if (generation_limit > 0 && generation >= generation_limit) return true;
+        return generation % DEADLINE_CHECK_GENERATIONS == 1 && chrono::steady_clock::now() >= deadline;
+    }
+
+public:
+    // verbose prints every improvement of the best fitness; with an archipelago the solver is one of its islands
+    explicit SudokuSolver(const Board<N>& b, const SolverOptions& options, Archipelago<N>* a = nullptr, int i = 0)
+        : candidates(b), context(options), arena(ARENA_SLOTS), verbose(options.verbose), archipelago(a), island(i),
+          hybrid(options.kind == HYBRID_SOLVER), deadline(options.deadline), generation_limit(options.generation_limit) {
+        for (int k = 0; k < ARENA_SLOTS; ++k) {
+            members[k] = k;
+        }
+    }
+
+    // a new puzzle for this instance: the population, the arena and the checked boards are kept,
+    // so a long-lived solver allocates nothing per puzzle; an archipelago island is not reset this way
+    void reset(const Board<N>& b, const SolverOptions& options) {
+        candidates = SudokuCandidates<N>(b);
+        context.generator = Xoshiro256(options.seed);
+        verbose = options.verbose;
+        hybrid = options.kind == HYBRID_SOLVER;
+        deadline = options.deadline;
+        generation_limit = options.generation_limit;
+        for (int k = 0; k < ARENA_SLOTS; ++k) {
+            members[k] = k;
+        }
+    }
+
+    // the solution once solved, the best board found when timed out
+    const Board<N>& result() const { return solution; }
+    const SolveStats& statistics() const { return stats; }
+
+    SolveStatus solve() {
+        int iters_without_changing = 0;
+        int current_fitness = 0;
+        // nothing may leak from the previous puzzle solved by this instance
+        context.rows_checked.clear();
+        context.crazy_mutation = CRAZY_MUTATION_INITIAL_PERCENT;
+        stats = SolveStats();
+        preprocessing();
+        // conflicting givens, or a cell or a digit the deductions left without a place: no generation can fix that
+        if (candidates.contradiction()) {
+            return UNSOLVABLE;
+        }
+        if (unknown_numbers == 0) {
+            solution = board;
+            return finish();
+        }
+        createPopulation();
+        for (int generation = 1; ; ++generation) {
+            // another island has already solved the puzzle
+            if (archipelago && archipelago->solved.load(memory_order_relaxed)) {
+                return TIMED_OUT;
+            }
+            stats.generations = generation;
+
+            makeChildren();  // спаривание + мутации
+            removeDregs();   // сортировка и удаление худших
+
+            int min_fit = min_fitness();
+            if (min_fit == 0) {
+                return finish();
+            }
+            if (stats.fitness < 0 || min_fit < stats.fitness) {
+                stats.fitness = min_fit;
+                solution = arena.boards[best_slot];
+            }
+            if (outOfBudget(generation)) {
+                if (verbose) context.rows_checked.report(cerr);
+                return TIMED_OUT;
+            }
+            if (current_fitness == min_fit) {
+                iters_without_changing++;
+            } else {
+                if (verbose) cerr << min_fit << '\n';
+                current_fitness = min_fit;
+                context.crazy_mutation = CRAZY_MUTATION_INITIAL_PERCENT;
+                iters_without_changing = 0;
+            }
+            if (iters_without_changing >= MAX_REPEATING_RESULT) {
+                if (context.crazy_mutation == CRAZY_MUTATION_INITIAL_PERCENT) {
+                    context.crazy_mutation = CRAZY_MUTATION_MAXIMUM_PERCENT;
+                    TRACE_COUNT(CRAZY_MUTATION);
+                } else {
+                    context.crazy_mutation = CRAZY_MUTATION_INITIAL_PERCENT;
+                    createPopulation();
+                    ++stats.restarts;
+                    TRACE_COUNT(RESTART);
+                }
+                iters_without_changing = 0;
+            }
+            if (archipelago && generation % MIGRATION_INTERVAL == 0) {
+                migrate();
+            }
+        }
+    }
+};
+
+// island model: one genetic solver per thread, each with its own random stream, sharing an archipelago
+template <int N>
+SolveStatus solveIslands(const Board<N>& puzzle, const SolverOptions& options, Board<N>& solution, SolveStats* stats) {
+    int islands = options.islands;
+    Archipelago<N> archipelago(islands);
+    seed_seq seq{options.seed};
+    vector<unsigned> seeds(islands);
+    seq.generate(seeds.begin(), seeds.end());
+    vector<SolveStats> island_stats(islands);
+    vector<SolveStatus> island_status(islands);
+    vector<Board<N>> island_best(islands);
+
+    vector<thread> threads;
+    for (int i = 0; i < islands; ++i) {
+        threads.emplace_back([&, i] {
+            SolverOptions island_options = options;
+            island_options.verbose = options.verbose && i == 0;
+            island_options.seed = seeds[i];
+            SudokuSolver<N> sudoku = SudokuSolver<N>(puzzle, island_options, &archipelago, i);
+            island_status[i] = sudoku.solve();
+            island_stats[i] = sudoku.statistics();
+            island_best[i] = sudoku.result();
+        });
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
+    // the work of all islands together
+    if (stats) {
+        for (const SolveStats& s : island_stats) {
+            stats->generations += s.generations;
+            stats->restarts += s.restarts;
+        }
+    }
+    if (archipelago.solved) {
+        solution = archipelago.solution;
+        if (stats) stats->fitness = 0;
+        return SOLVED;
+    }
+    // every island runs the same preprocessing, so they all find the contradiction
+    if (island_status[0] == UNSOLVABLE) return UNSOLVABLE;
+    // timed out: the best board of all islands
+    int best = 0;
+    for (int i = 1; i < islands; ++i) {
+        if (island_stats[i].fitness >= 0 && (island_stats[best].fitness < 0 || island_stats[i].fitness < island_stats[best].fitness)) {
+            best = i;
+        }
+    }
+    solution = island_best[best];
+    if (stats) stats->fitness = island_stats[best].fitness;
+    return TIMED_OUT;
+}
+
+// exact backend: propagation with the candidate engine, then backtracking on the cell with the fewest candidates
+template <int N>
+class ExactSolver {
+private:
+    SudokuCandidates<N> candidates;
+    Board<N> solution;
+    long long nodes = 0;
+    chrono::steady_clock::time_point deadline;
+    bool timed_out = false;
+
+    bool search(SudokuCandidates<N>& state) {
+        ++nodes;
+        if (nodes % DEADLINE_CHECK_NODES == 1 && chrono::steady_clock::now() >= deadline) {
+            timed_out = true;
+        }
+        if (timed_out) return false;
+        state.propagate();
+        if (state.contradiction()) return false;
+        if (state.unknown_numbers == 0) {
+            solution = state.board;
+            return true;
+        }
+
+        int best = state.fewestCandidates();
+        for (Mask<N> m = state.cand[best]; m; m &= m - 1) {
+            SudokuCandidates<N> next = state;
+            next.place(best, __builtin_ctz(m));
+            if (search(next)) return true;
+        }
+        return false;
+    }
+
+public:
+    ExactSolver(const Board<N>& b, const SolverOptions& options) : candidates(b), deadline(options.deadline) {}
+
+    const Board<N>& result() const { return solution; }
+    long long searchNodes() const { return nodes; }
+
+    // a search that ran out of time has no board to offer, unlike the genetic algorithm
+    SolveStatus solve() {
+        TRACE_PHASE(EXACT_SEARCH);
+        if (search(candidates)) return SOLVED;
+        return timed_out ? TIMED_OUT : UNSOLVABLE;
+    }
+};
+
+// more than one island runs the genetic algorithm in parallel on this puzzle;
+// stats, when given, receive the work the solver did. The solution is written when the puzzle is solved,
+// and when a genetic run times out it receives the best board found, whose fitness is in stats.
+// A single genetic run uses the given solver instead of a new one, if there is one
+template <int N>
+SolveStatus solvePuzzle(const Board<N>& puzzle, SolverOptions options, Board<N>& solution, SolveStats* stats = nullptr,
+                        SudokuSolver<N>* reused = nullptr) {
+    if (options.time_limit > 0) {
+        auto budget = chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(options.time_limit));
+        options.deadline = min(options.deadline, chrono::steady_clock::now() + budget);
+    }
+    if (options.kind != EXACT_SOLVER && options.islands > 1) {
+        return solveIslands(puzzle, options, solution, stats);
+    }
+    SolveStatus status;
+    if (options.kind != EXACT_SOLVER && reused) {
+        reused->reset(puzzle, options);
+        status = reused->solve();
+        if (stats) *stats = reused->statistics();
+        if (status != UNSOLVABLE) solution = reused->result();
+    } else if (options.kind != EXACT_SOLVER) {
+        SudokuSolver<N> sudoku = SudokuSolver<N>(puzzle, options);
+        status = sudoku.solve();
+        if (stats) *stats = sudoku.statistics();
+        if (status != UNSOLVABLE) solution = sudoku.result();
+    } else {
+        ExactSolver<N> sudoku = ExactSolver<N>(puzzle, options);
+        status = sudoku.solve();
+        if (stats) stats->nodes = sudoku.searchNodes();
+        if (status == SOLVED) solution = sudoku.result();
+    }
+    return status;
+}
+
+// runs tasks 0..count-1 on a fixed number of threads; every worker starts with its own contiguous
+// range of tasks, takes from the front of it and steals from the back of the others once it is empty
+class WorkStealingPool {
+private:
+    struct alignas(64) TaskRange {
+        mutex m;
+        int begin = 0;
+        int end = 0;
+    };
+
+    int threads;
+    vector<TaskRange> ranges;
+
+    bool take(int worker, int& task) {
+        {
+            TaskRange& own = ranges[worker];
+            lock_guard<mutex> lock(own.m);
+            if (own.begin < own.end) {
+                task = own.begin++;
+                return true;
+            }
+        }
+        for (int k = 1; k < threads; ++k) {
+            TaskRange& victim = ranges[(worker + k) % threads];
+            lock_guard<mutex> lock(victim.m);
+            if (victim.begin < victim.end) {
+                task = --victim.end;
+                return true;
+            }
+        }
+        return false;
+    }
+
+public:
+    explicit WorkStealingPool(int t) : threads(max(t, 1)), ranges(threads) {}
+
+    template <class Job>
+    void run(int count, Job job) {
+        for (int w = 0; w < threads; ++w) {
+            ranges[w].begin = (long long)count * w / threads;
+            ranges[w].end = (long long)count * (w + 1) / threads;
+        }
+        auto work = [&](int worker) {
+            int task;
+            while (take(worker, task)) {
+                job(task);
+            }
+        };
+        vector<thread> workers;
+        for (int w = 1; w < threads; ++w) {
+            workers.emplace_back(work, w);
+        }
+        work(0);
+        for (thread& t : workers) {
+            t.join();
+        }
+    }
+};
+
+// counts the solutions of a puzzle up to a limit with the search of the exact solver, stopping as soon as
+// the limit is reached, so a limit of 2 tells whether the solution is unique. With more than one thread the
+// top of the search tree is expanded breadth-first and its subtrees are counted in parallel
+template <int N>
+class SolutionCounter {
+private:
+    SudokuCandidates<N> root;
+    long long limit;
+    chrono::steady_clock::time_point deadline;
+    atomic<long long> found{0};
+    atomic<long long> nodes{0};
+    atomic<bool> timed_out{false};
+
+    bool done() const {
+        return found.load(memory_order_relaxed) >= limit || timed_out.load(memory_order_relaxed);
+    }
+
+    void search(SudokuCandidates<N>& state, long long& searched) {
+        if (done()) return;
+        ++searched;
+        if (searched % DEADLINE_CHECK_NODES == 1 && chrono::steady_clock::now() >= deadline) {
+            timed_out = true;
+            return;
+        }
+        state.propagate();
+        if (state.contradiction()) return;
+        if (state.unknown_numbers == 0) {
+            ++found;
+            return;
+        }
+        int best = state.fewestCandidates();
+        for (Mask<N> m = state.cand[best]; m && !done(); m &= m - 1) {
+            SudokuCandidates<N> next = state;
+            next.place(best, __builtin_ctz(m));
+            search(next, searched);
+        }
+    }
+
+public:
+    SolutionCounter(const Board<N>& puzzle, long long limit, const SolverOptions& options)
+        : root(puzzle), limit(max(limit, 1LL)), deadline(options.deadline) {}
+
+    // the number of solutions, at most the limit
+    long long count(int threads) {
+        vector<SudokuCandidates<N>> subtrees{root};
+        if (threads > 1) {
+            // the shallowest open nodes first, until every thread has several subtrees to take
+            deque<SudokuCandidates<N>> open{root};
+            size_t wanted = (size_t)threads * COUNT_SUBTREES_PER_THREAD;
+            while (!open.empty() && open.size() < wanted && !done()) {
+                SudokuCandidates<N> state = open.front();
+                open.pop_front();
+                ++nodes;
+                state.propagate();
+                if (state.contradiction()) continue;
+                if (state.unknown_numbers == 0) {
+                    ++found;
+                    continue;
+                }
+                int best = state.fewestCandidates();
+                for (Mask<N> m = state.cand[best]; m; m &= m - 1) {
+                    open.push_back(state);
+                    open.back().place(best, __builtin_ctz(m));
+                }
+            }
+            subtrees.assign(open.begin(), open.end());
+        }
+        WorkStealingPool(threads).run(subtrees.size(), [&](int t) {
+            long long searched = 0;
+            search(subtrees[t], searched);
+            nodes += searched;
+        });
+        return min(found.load(), limit);
+    }
+
+    bool timedOut() const { return timed_out; }
+    long long searchNodes() const { return nodes; }
+};
+
+// the line printed for a counted puzzle: the number of solutions, with a "+" when the limit was reached
+template <int N>
+string countSolutions(const Board<N>& puzzle, SolverOptions options, long long limit, int threads) {
+    if (options.time_limit > 0) {
+        auto budget = chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(options.time_limit));
+        options.deadline = min(options.deadline, chrono::steady_clock::now() + budget);
+    }
+    SolutionCounter<N> counter(puzzle, limit, options);
+    long long count = counter.count(threads);
+    if (count >= limit) return to_string(count) + "+";
+    return counter.timedOut() ? "Timed out" : to_string(count);
+}
+
+// what every input byte means to the parser: a digit value 1..35 (10 and above written as letters in either case),
+// an empty cell, a skipped byte, or an invalid one
+struct CharClasses {
+    static constexpr int8_t SKIP = -1;
+    static constexpr int8_t INVALID = -2;
+    int8_t value[256];
+
+    constexpr CharClasses() : value() {
+        for (int ch = 0; ch < 256; ++ch) {
+            value[ch] = INVALID;
+        }
+        for (char ch : {' ', '\t', '\r', '\n', '|', '+'}) {
+            value[(uint8_t)ch] = SKIP;
+        }
+        for (char ch : {'.', '0', '-'}) {
+            value[(uint8_t)ch] = 0;
+        }
+        for (int d = 1; d <= 9; ++d) {
+            value['0' + d] = d;
+        }
+        for (int d = 10; d < 36; ++d) {
+            value['A' + d - 10] = d;
+            value['a' + d - 10] = d;
+        }
+    }
+};
+
+constexpr CharClasses CHAR_CLASSES;
+
+enum ReadStatus { PUZZLE_READ, PUZZLE_INVALID, INPUT_END };
+
+// reads puzzles from a memory-mapped file, from stdin or a pipe through a large buffer, or from memory,
+// without iostreams or exceptions. Digits 1..SIDE are givens, '.', '0' and '-' are empty cells, whitespace,
+// '|' and '+' are skipped, so both the dash grid and one line of CELLS characters are accepted. The first
+// line holding cells tells the two apart: more than SIDE cells on it means one puzzle per line
+class PuzzleReader {
+private:
+    static constexpr size_t BUFFER_SIZE = 1 << 20;
+    enum Layout { UNKNOWN_LAYOUT, GRID_LAYOUT, LINE_LAYOUT };
+    int fd = -1;
+    void* mapping = nullptr;
+    size_t mapping_size = 0;
+    vector<char> buffer;
+    const char* data = nullptr;
+    size_t size = 0;
+    size_t pos = 0;
+    long long line = 1;
+    bool failed = false;
+    Layout layout = UNKNOWN_LAYOUT;
+
+    // the next chunk of a stream; false at its end
+    bool refill() {
+        if (fd < 0 || mapping) return false;
+        ssize_t n;
+        do {
+            n = read(fd, buffer.data(), buffer.size());
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0) return false;
+        data = buffer.data();
+        size = n;
+        pos = 0;
+        return true;
+    }
+
+public:
+    // "-" is stdin; regular files are mapped, anything else is read in chunks
+    explicit PuzzleReader(const string& path) {
+        fd = path == "-" ? 0 : open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            failed = true;
+            return;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                madvise(p, st.st_size, MADV_SEQUENTIAL);
+                mapping = p;
+                mapping_size = st.st_size;
+                data = (const char*)p;
+                size = mapping_size;
+                return;
+            }
+        }
+        buffer.resize(BUFFER_SIZE);
+    }
+
+    PuzzleReader(const char* text, size_t length) : data(text), size(length) {}
+
+    PuzzleReader(const PuzzleReader&) = delete;
+    PuzzleReader& operator=(const PuzzleReader&) = delete;
+
+    ~PuzzleReader() {
+        if (mapping) munmap(mapping, mapping_size);
+        if (fd > 0) close(fd);
+    }
+
+    bool ok() const { return !failed; }
+
+    // the next puzzle: a whole line of cells, or the next CELLS cells of a grid. A puzzle with invalid
+    // characters or digits above SIDE, and a line without exactly CELLS cells, is reported with its line
+    // and still consumes its cells, so the puzzles after it stay in step with the input
+    template <int N>
+    ReadStatus next(Board<N>& board) {
+        // cells seen, past CELLS on a line that is too long
+        int count = 0;
+        bool valid = true;
+        long long first_line = line;
+        while (layout != GRID_LAYOUT || count < CELLS<N>) {
+            if (pos == size && !refill()) break;
+            uint8_t ch = data[pos++];
+            int value = CHAR_CLASSES.value[ch];
+            if (value == CharClasses::SKIP) {
+                if (ch != '\n') continue;
+                ++line;
+                if (count == 0) continue;
+                if (layout == UNKNOWN_LAYOUT) layout = count > SIDE<N> ? LINE_LAYOUT : GRID_LAYOUT;
+                if (layout == LINE_LAYOUT) break;
+                continue;
+            }
+            if (count == 0) first_line = line;
+            if (value > SIDE<N> || value == CharClasses::INVALID) {
+                if (valid) {
+                    cerr << "line " << line << ": unexpected character '" << char(ch) << "'" << endl;
+                }
+                valid = false;
+                value = 0;
+            }
+            if (count < CELLS<N>) board.cells[count] = value;
+            ++count;
+        }
+        if (count == 0) return INPUT_END;
+        if (layout == UNKNOWN_LAYOUT) layout = count > SIDE<N> ? LINE_LAYOUT : GRID_LAYOUT;
+        if (layout == LINE_LAYOUT && count != CELLS<N>) {
+            cerr << "line " << first_line << ": " << count << " cells instead of " << CELLS<N> << endl;
+            return PUZZLE_INVALID;
+        }
+        if (count < CELLS<N>) {
+            cerr << "incomplete puzzle at the end of the input" << endl;
+            return PUZZLE_INVALID;
+        }
+        return valid ? PUZZLE_READ : PUZZLE_INVALID;
+    }
+};
+
+// write(2) until everything is written or it fails
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+// GRID_FORMAT is the grid of digits separated by spaces, LINE_FORMAT one line of CELLS digits per board
+enum OutputFormat { DEFAULT_FORMAT, GRID_FORMAT, LINE_FORMAT };
+
+// formats solutions and messages into a reusable buffer and writes it to stdout or a file in large chunks
+class SolutionWriter {
+private:
+    static constexpr size_t FLUSH_SIZE = 1 << 20;
+    int fd;
+    vector<char> buffer;
+    size_t used = 0;
+    bool failed = false;
+
+    // room for n more bytes
+    char* reserve(size_t n) {
+        if (used + n > buffer.size()) {
+            flush();
+            if (n > buffer.size()) buffer.resize(n);
+        }
+        return buffer.data() + used;
+    }
+
+public:
+    // "-" is stdout
+    explicit SolutionWriter(const string& path)
+        : fd(path == "-" ? 1 : open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)), buffer(FLUSH_SIZE) {
+        failed = fd < 0;
+    }
+
+    SolutionWriter(const SolutionWriter&) = delete;
+    SolutionWriter& operator=(const SolutionWriter&) = delete;
+
+    ~SolutionWriter() {
+        flush();
+        if (fd > 1) close(fd);
+    }
+
+    bool ok() const { return !failed; }
+
+    template <int N>
+    void write(const Board<N>& board, OutputFormat format) {
+        if (format == LINE_FORMAT) {
+            char* p = reserve(CELLS<N> + 1);
+            for (uint8_t elem : board.cells) {
+                *p++ = digitChar(elem);
+            }
+            *p++ = '\n';
+            used = p - buffer.data();
+            return;
+        }
+        char* p = reserve(CELLS<N> * 2 + SIDE<N>);
+        for (int i = 0; i < SIDE<N>; ++i) {
+            for (int j = 0; j < SIDE<N>; ++j) {
+                *p++ = digitChar(board.at(i, j));
+                *p++ = ' ';
+            }
+            *p++ = '\n';
+        }
+        used = p - buffer.data();
+    }
+
+    // one line of text
+    void message(const string& text) {
+        char* p = reserve(text.size() + 1);
+        p = copy(text.begin(), text.end(), p);
+        *p++ = '\n';
+        used = p - buffer.data();
+    }
+
+    void flush() {
+        if (!failed && !writeAll(fd, buffer.data(), used)) {
+            cerr << "cannot write the solutions" << endl;
+            failed = true;
+        }
+        used = 0;
+    }
+};
+
+// a symmetry of the board: transposition, then the rows and the columns taken in the listed order,
+// then the digits relabeled; every such transform keeps a solution a solution
+template <int N>
+struct Transform {
+    bool transpose = false;
+    array<uint8_t, SIDE<N>> rows{};
+    array<uint8_t, SIDE<N>> columns{};
+    // new label of every digit, 0 stays 0
+    array<uint8_t, SIDE<N> + 1> digits{};
+
+    // the cell of the original board that ends up at (i, j)
+    int source(int i, int j) const {
+        return transpose ? columns[j] * SIDE<N> + rows[i] : rows[i] * SIDE<N> + columns[j];
+    }
+
+    Board<N> apply(const Board<N>& board) const {
+        Board<N> out;
+        for (int i = 0; i < SIDE<N>; ++i) {
+            for (int j = 0; j < SIDE<N>; ++j) {
+                out.at(i, j) = digits[board.cells[source(i, j)]];
+            }
+        }
+        return out;
+    }
+
+    Board<N> revert(const Board<N>& board) const {
+        array<uint8_t, SIDE<N> + 1> original{};
+        for (int d = 1; d <= SIDE<N>; ++d) {
+            original[digits[d]] = d;
+        }
+        Board<N> out;
+        for (int i = 0; i < SIDE<N>; ++i) {
+            for (int j = 0; j < SIDE<N>; ++j) {
+                out.cells[source(i, j)] = original[board.at(i, j)];
+            }
+        }
+        return out;
+    }
+};
+
+// canonical form of a puzzle: the lexicographically smallest board, empty cells first, among all the
+// transposed, row- and column-permuted and relabeled versions of it. Rows move only within their band
+// and columns only within their stack. For a fixed arrangement the smallest relabeling numbers the digits
+// in order of first appearance, so only arrangements are searched: every column order, and the rows
+// band by band, a row order being dropped as soon as it is behind the best board so far. On 16x16 and
+// 25x25 the column orders are too many (24^4 and 120^5), so there the form only covers row orders and
+// relabeling, and variants with permuted columns or transposed get forms of their own. Sparse boards tie
+// on almost every row, so the search stops after CANONICAL_SEARCH_NODES nodes or at the deadline, and the
+// puzzle then stands for itself with the identity transform
+template <int N>
+class Canonicalizer {
+private:
+    static constexpr bool COLUMN_ORDERS = N <= 3;
+    // the puzzle and its transposition
+    Board<N> oriented[2];
+    Transform<N> current;
+    // the relabeled rows of the arrangement being tried
+    Board<N> path;
+    Board<N> best;
+    Transform<N> best_transform;
+    bool have_best = false;
+    long long updates = 0;
+    long long nodes = 0;
+    chrono::steady_clock::time_point deadline;
+    bool stopped = false;
+
+    // true once the search has used up its nodes or its time
+    bool exhausted() {
+        if (!stopped && (++nodes > CANONICAL_SEARCH_NODES ||
+                         (nodes % DEADLINE_CHECK_NODES == 1 && chrono::steady_clock::now() >= deadline))) {
+            stopped = true;
+        }
+        return stopped;
+    }
+
+    void searchRows(int i, const array<uint8_t, SIDE<N> + 1>& labels, int next_label, bool ahead) {
+        if (exhausted()) return;
+        if (i == SIDE<N>) {
+            if (!have_best || ahead) {
+                have_best = true;
+                ++updates;
+                best = path;
+                best_transform = current;
+                best_transform.digits = labels;
+            }
+            return;
+        }
+        // the rows of the band still free, relabeled; only those equal to the smallest of them can lead
+        // to the smallest board, so the search branches on ties only
+        int band = i / N * N;
+        int candidates[N];
+        uint8_t rows[N][SIDE<N>];
+        array<uint8_t, SIDE<N> + 1> row_labels[N];
+        int row_next[N];
+        int count = 0, smallest = -1;
+        for (int r = band; r < band + N; ++r) {
+            bool used = false;
+            for (int k = band; k < i; ++k) {
+                used |= current.rows[k] == r;
+            }
+            if (used) continue;
+
+            row_labels[count] = labels;
+            row_next[count] = next_label;
+            const uint8_t* cells = &oriented[current.transpose].cells[r * SIDE<N>];
+            for (int j = 0; j < SIDE<N>; ++j) {
+                int d = cells[current.columns[j]];
+                if (d != 0 && row_labels[count][d] == 0) row_labels[count][d] = ++row_next[count];
+                rows[count][j] = row_labels[count][d];
+            }
+            candidates[count] = r;
+            if (smallest < 0 || compareRows(rows[count], rows[smallest]) < 0) smallest = count;
+            ++count;
+        }
+
+        bool row_ahead = ahead || !have_best;
+        if (!row_ahead) {
+            int order = compareRows(rows[smallest], &best.cells[i * SIDE<N>]);
+            if (order > 0) return;
+            row_ahead = order < 0;
+        }
+        copy_n(rows[smallest], SIDE<N>, &path.cells[i * SIDE<N>]);
+        for (int k = 0; k < count; ++k) {
+            if (compareRows(rows[k], rows[smallest]) != 0) continue;
+            current.rows[i] = candidates[k];
+            long long before = updates;
+            searchRows(i + 1, row_labels[k], row_next[k], row_ahead);
+            // a new best board shares this prefix, so the next rows are compared with it again
+            if (updates != before) row_ahead = false;
+        }
+    }
+
+    static int compareRows(const uint8_t* a, const uint8_t* b) {
+        for (int j = 0; j < SIDE<N>; ++j) {
+            if (a[j] != b[j]) return int(a[j]) - int(b[j]);
+        }
+        return 0;
+    }
+
+    // true if the columns placed so far already put every possible first row behind the best board
+    bool behind(int placed) const {
+        if (!have_best) return false;
+        for (int r = 0; r < N; ++r) {
+            const uint8_t* cells = &oriented[current.transpose].cells[r * SIDE<N>];
+            array<uint8_t, SIDE<N> + 1> labels{};
+            int next_label = 0, order = 0;
+            for (int j = 0; j < placed && order == 0; ++j) {
+                int d = cells[current.columns[j]];
+                if (d != 0 && labels[d] == 0) labels[d] = ++next_label;
+                order = int(labels[d]) - int(best.at(0, j));
+            }
+            if (order <= 0) return false;
+        }
+        return true;
+    }
+
+    void searchColumns(int stack) {
+        if (exhausted() || behind(stack)) return;
+        if (stack == SIDE<N> || !COLUMN_ORDERS) {
+            searchRows(0, {}, 0, false);
+            return;
+        }
+        auto first = current.columns.begin() + stack, last = first + N;
+        iota(first, last, stack);
+        do {
+            searchColumns(stack + N);
+        } while (next_permutation(first, last));
+    }
+
+public:
+    // the canonical form of the puzzle and the transform that turns the puzzle into it, or the puzzle
+    // itself and the identity when the search stopped early
+    Board<N> canonicalize(const Board<N>& board, Transform<N>& transform,
+                          chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max()) {
+        this->deadline = deadline;
+        nodes = 0;
+        stopped = false;
+        oriented[0] = board;
+        for (int c = 0; c < CELLS<N>; ++c) {
+            oriented[1].cells[c] = board.cells[c % SIDE<N> * SIDE<N> + c / SIDE<N>];
+        }
+        have_best = false;
+        for (bool transpose : {false, true}) {
+            if (transpose && !COLUMN_ORDERS) break;
+            current.transpose = transpose;
+            iota(current.columns.begin(), current.columns.end(), 0);
+            searchColumns(0);
+        }
+        if (stopped) {
+            transform = Transform<N>();
+            iota(transform.rows.begin(), transform.rows.end(), 0);
+            iota(transform.columns.begin(), transform.columns.end(), 0);
+            iota(transform.digits.begin(), transform.digits.end(), 0);
+            return board;
+        }
+        // digits missing from the puzzle take the labels left over
+        transform = best_transform;
+        int next_label = *max_element(transform.digits.begin(), transform.digits.end());
+        for (int d = 1; d <= SIDE<N>; ++d) {
+            if (transform.digits[d] == 0) transform.digits[d] = ++next_label;
+        }
+        return best;
+    }
+
+    // false when the last puzzle was keyed as it is
+    bool complete() const { return !stopped; }
+};
+
+// every unit holds all digits and the givens of the puzzle are kept
+template <int N>
+bool validSolution(const Board<N>& puzzle, const Board<N>& solution) {
+    for (int c = 0; c < CELLS<N>; ++c) {
+        if (puzzle.cells[c] != 0 && puzzle.cells[c] != solution.cells[c]) return false;
+    }
+    for (int u = 0; u < SIDE<N>; ++u) {
+        Mask<N> row = 0, column = 0, box = 0;
+        for (int k = 0; k < SIDE<N>; ++k) {
+            row |= Mask<N>(1) << solution.at(u, k);
+            column |= Mask<N>(1) << solution.at(k, u);
+            box |= Mask<N>(1) << solution.in_box(u, k);
+        }
+        if (row != ALL_DIGITS<N> || column != ALL_DIGITS<N> || box != ALL_DIGITS<N>) return false;
+    }
+    return true;
+}
+
+// LRU cache of solutions keyed by the canonical form of the puzzle, shared by the threads of a batch;
+// entries are found by the 64-bit hash of the form and checked against the whole board
+template <int N>
+class SolutionCache {
+private:
+    struct Entry {
+        uint64_t hash;
+        Board<N> puzzle;
+        Board<N> solution;
+    };
+    size_t capacity;
+    // most recently used first
+    list<Entry> entries;
+    unordered_map<uint64_t, typename list<Entry>::iterator> index;
+    mutex m;
+
+public:
+    long long hits = 0;
+    long long misses = 0;
+    long long evictions = 0;
+
+    explicit SolutionCache(size_t capacity) : capacity(max<size_t>(capacity, 1)) {
+        index.reserve(this->capacity);
+    }
+
+    bool find(const Board<N>& canonical, Board<N>& solution) {
+        uint64_t hash = boardHash(canonical);
+        lock_guard<mutex> lock(m);
+        auto it = index.find(hash);
+        if (it == index.end() || it->second->puzzle.cells != canonical.cells) {
+            ++misses;
+            return false;
+        }
+        entries.splice(entries.begin(), entries, it->second);
+        solution = it->second->solution;
+        ++hits;
+        return true;
+    }
+
+    // a different puzzle with the same hash is replaced
+    void insert(const Board<N>& canonical, const Board<N>& solution) {
+        uint64_t hash = boardHash(canonical);
+        lock_guard<mutex> lock(m);
+        auto it = index.find(hash);
+        if (it != index.end()) {
+            entries.erase(it->second);
+            index.erase(it);
+        } else if (entries.size() == capacity) {
+            index.erase(entries.back().hash);
+            entries.pop_back();
+            ++evictions;
+        }
+        entries.push_front({hash, canonical, solution});
+        index[hash] = entries.begin();
+    }
+
+    // the file holds pairs of lines, a canonical puzzle and its solution, least recently used first;
+    // a missing file is an empty cache. A pair whose solution does not solve its puzzle is skipped, and
+    // loading stops at the first line that is not a board of this size. False if either happened
+    bool load(const string& path) {
+        PuzzleReader reader(path);
+        if (!reader.ok()) return true;
+        Board<N> canonical, solution;
+        bool clean = true;
+        for (long long pair = 1;; ++pair) {
+            ReadStatus status = reader.next(canonical);
+            if (status == INPUT_END) break;
+            if (status == PUZZLE_READ) status = reader.next(solution);
+            if (status != PUZZLE_READ) {
+                cerr << path << ": entry " << pair << " cannot be read, the rest of the file is ignored" << endl;
+                return false;
+            }
+            if (!validSolution(canonical, solution)) {
+                cerr << path << ": entry " << pair << " is not a solution of its puzzle, skipped" << endl;
+                clean = false;
+                continue;
+            }
+            insert(canonical, solution);
+        }
+        return clean;
+    }
+
+    bool save(const string& path) {
+        SolutionWriter writer(path);
+        if (!writer.ok()) return false;
+        for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+            writer.write(it->puzzle, LINE_FORMAT);
+            writer.write(it->solution, LINE_FORMAT);
+        }
+        writer.flush();
+        return writer.ok();
+    }
+
+    void report(ostream& out) const {
+        long long lookups = hits + misses;
+        out << "solution cache: " << hits << " hits, " << misses << " misses ("
+            << (lookups ? 100 * hits / lookups : 0) << "% hits), " << evictions << " evictions, "
+            << entries.size() << " entries" << endl;
+    }
+};
+
+// the puzzle is looked up in the cache by its canonical form, and only solved on a miss
+template <int N>
+SolveStatus solveCached(const Board<N>& puzzle, SolverOptions options, Board<N>& solution,
+                        SolutionCache<N>* cache, SolveStats* stats = nullptr, SudokuSolver<N>* reused = nullptr) {
+    if (!cache) return solvePuzzle(puzzle, options, solution, stats, reused);
+    // the budget of the puzzle starts before its canonical form is searched
+    if (options.time_limit > 0) {
+        auto budget = chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(options.time_limit));
+        options.deadline = min(options.deadline, chrono::steady_clock::now() + budget);
+        options.time_limit = 0;
+    }
+    Transform<N> transform;
+    Board<N> canonical = Canonicalizer<N>().canonicalize(puzzle, transform, options.deadline);
+    Board<N> canonical_solution;
+    if (cache->find(canonical, canonical_solution)) {
+        solution = transform.revert(canonical_solution);
+        return SOLVED;
+    }
+    SolveStatus status = solvePuzzle(puzzle, options, solution, stats, reused);
+    if (status == SOLVED) cache->insert(canonical, transform.apply(solution));
+    return status;
+}
+
+// the lines of a file descriptor without their line breaks, read in 64 KiB chunks
+class LineReader {
+private:
+    int fd;
+    vector<char> buffer;
+    size_t begin = 0;
+    size_t end = 0;
+
+public:
+    explicit LineReader(int fd) : fd(fd), buffer(1 << 16) {}
+
+    // false at the end of the input; a last line without a line break is still returned
+    bool next(string& line) {
+        line.clear();
+        while (true) {
+            const char* first = buffer.data() + begin;
+            const char* newline = static_cast<const char*>(memchr(first, '\n', end - begin));
+            if (newline) {
+                line.append(first, newline);
+                begin = newline - buffer.data() + 1;
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                return true;
+            }
+            line.append(first, end - begin);
+            begin = end = 0;
+            ssize_t n;
+            do {
+                n = read(fd, buffer.data(), buffer.size());
+            } while (n < 0 && errno == EINTR);
+            if (n <= 0) return !line.empty();
+            end = n;
+        }
+    }
+};
+
+// the solver service: clients send one puzzle per line and get one line back per puzzle, in the order
+// of their requests: the status (solved, unsolvable, timeout or invalid), the board or "-", and the
+// microseconds the request waited for a worker and spent being solved. Every worker thread keeps one
+// genetic solver for all its puzzles, and request k is solved with the seed --seed + k
+template <int N>
+class SolverService {
+private:
+    struct Stream;
+
+    struct Job {
+        Stream* stream;
+        unsigned id;
+        Board<N> puzzle;
+        bool valid;
+        bool done = false;
+        SolveStatus status = UNSOLVABLE;
+        SolveStats stats;
+        Board<N> solution;
+        chrono::steady_clock::time_point received, started, finished;
+    };
+
+    // one client: a reader queues its requests, a writer sends the answers back in order
+    struct Stream {
+        int out;
+        mutex m;
+        condition_variable changed;
+        deque<unique_ptr<Job>> pending;
+        bool closed = false;
+    };
+
+    SolverOptions options;
+    SolutionCache<N>* cache;
+    mutex m;
+    condition_variable queued;
+    deque<Job*> queue;
+    bool stopping = false;
+    vector<thread> workers;
+    atomic<unsigned> requests{0};
+    // sockets of the connected clients, so a shutdown can end their input
+    mutex clients_m;
+    condition_variable clients_changed;
+    vector<int> clients;
+
+    void work() {
+        SudokuSolver<N> solver = SudokuSolver<N>(Board<N>(), options);
+        while (true) {
+            Job* job;
+            {
+                unique_lock<mutex> lock(m);
+                queued.wait(lock, [this] { return stopping || !queue.empty(); });
+                if (queue.empty()) return;
+                job = queue.front();
+                queue.pop_front();
+            }
+            SolverOptions job_options = options;
+            job_options.seed = options.seed + job->id;
+            job->started = chrono::steady_clock::now();
+            job->status = solveCached(job->puzzle, job_options, job->solution, cache, &job->stats, &solver);
+            job->finished = chrono::steady_clock::now();
+            lock_guard<mutex> lock(job->stream->m);
+            job->done = true;
+            job->stream->changed.notify_all();
+        }
+    }
+
+    static string answer(const Job& job) {
+        static constexpr const char* STATUS_NAMES[] = {"solved", "unsolvable", "timeout"};
+        string line = job.valid ? STATUS_NAMES[job.status] : "invalid";
+        line += ' ';
+        if (job.valid && (job.status == SOLVED || (job.status == TIMED_OUT && job.stats.fitness >= 0))) {
+            for (uint8_t d : job.solution.cells) {
+                line += digitChar(d);
+            }
+        } else {
+            line += '-';
+        }
+        auto micros = [](chrono::steady_clock::duration d) {
+            return to_string(chrono::duration_cast<chrono::microseconds>(d).count());
+        };
+        line += ' ' + micros(job.started - job.received) + ' ' + micros(job.finished - job.started) + '\n';
+        return line;
+    }
+
+    void writeAnswers(Stream& stream) {
+        bool connected = true;
+        while (true) {
+            unique_ptr<Job> job;
+            {
+                unique_lock<mutex> lock(stream.m);
+                stream.changed.wait(lock, [&] {
+                    return (!stream.pending.empty() && stream.pending.front()->done) || (stream.closed && stream.pending.empty());
+                });
+                if (stream.pending.empty()) return;
+                job = move(stream.pending.front());
+                stream.pending.pop_front();
+                stream.changed.notify_all();
+            }
+            // a client that hung up still has its queued requests solved, the answers are dropped
+            string line = answer(*job);
+            connected = connected && writeAll(stream.out, line.data(), line.size());
+        }
+    }
+
+public:
+    SolverService(const SolverOptions& options, SolutionCache<N>* cache, int threads) : options(options), cache(cache) {
+        this->options.islands = 1;
+        for (int t = 0; t < max(threads, 1); ++t) {
+            workers.emplace_back([this] { work(); });
+        }
+    }
+
+    ~SolverService() {
+        {
+            lock_guard<mutex> lock(m);
+            stopping = true;
+        }
+        queued.notify_all();
+        for (thread& t : workers) {
+            t.join();
+        }
+    }
+
+    // answers the requests of one client until its input ends
+    void serve(int in, int out) {
+        Stream stream;
+        stream.out = out;
+        thread writer([&] { writeAnswers(stream); });
+        LineReader lines(in);
+        string line;
+        while (lines.next(line)) {
+            if (line.find_first_not_of(" \t") == string::npos) continue;
+            auto job = make_unique<Job>();
+            job->stream = &stream;
+            job->id = requests++;
+            job->received = chrono::steady_clock::now();
+            // the reader takes the line as one puzzle, so cells left after CELLS of them make it invalid
+            PuzzleReader reader(line.data(), line.size());
+            job->valid = reader.next(job->puzzle) == PUZZLE_READ;
+            if (!job->valid) {
+                job->started = job->finished = job->received;
+                job->done = true;
+            }
+            Job* queued_job = job.get();
+            {
+                unique_lock<mutex> lock(stream.m);
+                stream.changed.wait(lock, [&] { return stream.pending.size() < SERVICE_PIPELINE; });
+                stream.pending.push_back(move(job));
+                if (queued_job->done) stream.changed.notify_all();
+            }
+            if (!queued_job->done) {
+                lock_guard<mutex> lock(m);
+                queue.push_back(queued_job);
+                queued.notify_one();
+            }
+        }
+        {
+            lock_guard<mutex> lock(stream.m);
+            stream.closed = true;
+            stream.changed.notify_all();
+        }
+        writer.join();
+    }
+
+    // SIGINT and SIGTERM stop a service on a socket; they are blocked in every thread before the workers
+    // start and read from a signalfd by listen()
+    static sigset_t stopSignals() {
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        return signals;
+    }
+
+    // every connection to the unix socket at path is a client of its own. On SIGINT or SIGTERM the service
+    // stops accepting, ends the input of every client, answers the requests they already sent and returns
+    int listen(const string& path) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) {
+            cerr << "socket path too long: " << path << endl;
+            return 1;
+        }
+        copy(path.begin(), path.end(), address.sun_path);
+        int server = socket(AF_UNIX, SOCK_STREAM, 0);
+        unlink(path.c_str());
+        if (server < 0 || bind(server, (sockaddr*)&address, sizeof(address)) < 0 || ::listen(server, SOMAXCONN) < 0) {
+            cerr << "cannot listen on " << path << ": " << strerror(errno) << endl;
+            return 1;
+        }
+        sigset_t signals = stopSignals();
+        int stop = signalfd(-1, &signals, SFD_CLOEXEC);
+        if (stop < 0) {
+            cerr << "cannot watch for signals: " << strerror(errno) << endl;
+            return 1;
+        }
+        cerr << "listening on " << path << endl;
+        pollfd watched[2] = {{server, POLLIN, 0}, {stop, POLLIN, 0}};
+        while (true) {
+            if (poll(watched, 2, -1) < 0) {
+                if (errno == EINTR) continue;
+                cerr << "poll failed: " << strerror(errno) << endl;
+                return 1;
+            }
+            if (watched[1].revents) break;
+            int client = accept(server, nullptr, nullptr);
+            if (client < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                cerr << "accept failed: " << strerror(errno) << endl;
+                return 1;
+            }
+            {
+                lock_guard<mutex> lock(clients_m);
+                clients.push_back(client);
+            }
+            thread([this, client] {
+                serve(client, client);
+                lock_guard<mutex> lock(clients_m);
+                clients.erase(find(clients.begin(), clients.end(), client));
+                close(client);
+                clients_changed.notify_all();
+            }).detach();
+        }
+
+        cerr << "stopping, " << requests << " requests served" << endl;
+        close(stop);
+        close(server);
+        unlink(path.c_str());
+        unique_lock<mutex> lock(clients_m);
+        for (int client : clients) {
+            shutdown(client, SHUT_RD);
+        }
+        clients_changed.wait(lock, [this] { return clients.empty(); });
+        return 0;
+    }
+};
+
+// batch mode as a pipeline over BATCH_SLOTS chunks of puzzles: while the workers solve one chunk, the next
+// one is parsed and the finished prefix of the earlier ones is written, each by whichever worker gets there
+// first. The workers live for the whole batch and take puzzles one at a time from the oldest chunk that has
+// any left, so a slow puzzle holds up only the output behind it, never the other workers
+template <int N>
+class BatchPipeline {
+private:
+    // Slot::next while the slot is being refilled, above any task index
+    static constexpr int CLOSED = 1 << 30;
+
+    struct Slot {
+        vector<Board<N>> puzzles = vector<Board<N>>(BATCH_CHUNK);
+        vector<Board<N>> solutions = vector<Board<N>>(BATCH_CHUNK);
+        vector<char> valid = vector<char>(BATCH_CHUNK);
+        vector<SolveStatus> statuses = vector<SolveStatus>(BATCH_CHUNK);
+        vector<string> counts = vector<string>(BATCH_CHUNK);
+        unique_ptr<atomic<bool>[]> done{new atomic<bool>[BATCH_CHUNK]};
+        atomic<int> size{0};
+        // the next puzzle of the chunk to hand out
+        atomic<int> next{CLOSED};
+    };
+
+    PuzzleReader& reader;
+    SolutionWriter& writer;
+    const SolverOptions& options;
+    SolutionCache<N>* cache;
+    long long count_limit;
+    OutputFormat format;
+    Slot slots[BATCH_SLOTS];
+    // puzzles parsed and written so far; every chunk before the claimed one has no puzzles left to hand out
+    atomic<long long> read{0};
+    atomic<long long> written{0};
+    atomic<long long> claimed{0};
+    atomic<bool> input_end{false};
+    mutex read_m;
+    mutex write_m;
+    // idle workers wait for a new chunk, a free slot or the end of the batch
+    mutex m;
+    condition_variable changed;
+
+    long long chunks() const { return (read + BATCH_CHUNK - 1) / BATCH_CHUNK; }
+
+    bool finished() const { return input_end && written == read; }
+
+    // a chunk is read ahead while fewer than two have puzzles left and the slot of the next one is written out
+    bool readable() const {
+        long long chunk = chunks();
+        return !input_end && chunk - claimed < 2 && chunk - written / BATCH_CHUNK < BATCH_SLOTS;
+    }
+
+    void notify() {
+        lock_guard<mutex> lock(m);
+        changed.notify_all();
+    }
+
+    bool take(Slot*& slot, int& task) {
+        while (true) {
+            long long chunk = claimed;
+            if (chunk >= chunks()) return false;
+            Slot& candidate = slots[chunk % BATCH_SLOTS];
+            int t = candidate.next.fetch_add(1);
+            if (t < candidate.size) {
+                slot = &candidate;
+                task = t;
+                return true;
+            }
+            claimed.compare_exchange_strong(chunk, chunk + 1);
+        }
+    }
+
+    // parses the next chunk; false if there was nothing to read or another worker is reading and wait is false
+    bool readAhead(bool wait) {
+        if (!readable()) return false;
+        unique_lock<mutex> lock(read_m, defer_lock);
+        if (wait) {
+            lock.lock();
+        } else if (!lock.try_lock()) {
+            return false;
+        }
+        if (!readable()) return false;
+        Slot& slot = slots[chunks() % BATCH_SLOTS];
+        slot.next = CLOSED;
+        int count = 0;
+        Board<N> board;
+        ReadStatus status;
+        while (count < BATCH_CHUNK && (status = reader.next(board)) != INPUT_END) {
+            slot.puzzles[count] = board;
+            slot.valid[count] = status == PUZZLE_READ;
+            slot.done[count] = false;
+            ++count;
+        }
+        slot.size = count;
+        slot.next = 0;
+        read += count;
+        if (count < BATCH_CHUNK) input_end = true;
+        lock.unlock();
+        writeFinished(false);
+        notify();
+        return true;
+    }
+
+    void solve(Slot& slot, int t) {
+        if (!slot.valid[t]) {
+            slot.statuses[t] = UNSOLVABLE;
+        } else if (count_limit > 0) {
+            slot.counts[t] = countSolutions(slot.puzzles[t], options, count_limit, 1);
+        } else {
+            slot.statuses[t] = solveCached(slot.puzzles[t], options, slot.solutions[t], cache);
+        }
+    }
+
+    void output(Slot& slot, int t) {
+        if (!slot.valid[t]) {
+            writer.message("Invalid puzzle");
+        } else if (count_limit > 0) {
+            writer.message(slot.counts[t]);
+        } else if (slot.statuses[t] == SOLVED) {
+            writer.write(slot.solutions[t], format);
+        } else {
+            writer.message(slot.statuses[t] == UNSOLVABLE ? "No solution" : "Timed out");
+        }
+    }
+
+    bool nextDone() const {
+        long long next = written;
+        return next < read && slots[next / BATCH_CHUNK % BATCH_SLOTS].done[next % BATCH_CHUNK];
+    }
+
+    // writes the finished puzzles that follow the written ones. A worker that finds the writer busy leaves its
+    // puzzle to it, and the writer looks again after letting go, so no finished puzzle is left behind
+    void writeFinished(bool wait) {
+        while (true) {
+            atomic_thread_fence(memory_order_seq_cst);
+            unique_lock<mutex> lock(write_m, defer_lock);
+            if (wait) {
+                lock.lock();
+            } else if (!lock.try_lock()) {
+                return;
+            }
+            long long first = written, last = first, end = read;
+            while (last < end) {
+                Slot& slot = slots[last / BATCH_CHUNK % BATCH_SLOTS];
+                int t = last % BATCH_CHUNK;
+                if (!slot.done[t]) break;
+                output(slot, t);
+                ++last;
+            }
+            written = last;
+            lock.unlock();
+            atomic_thread_fence(memory_order_seq_cst);
+            if (last / BATCH_CHUNK != first / BATCH_CHUNK || finished()) notify();
+            if (!nextDone()) return;
+        }
+    }
+
+    void work() {
+        Slot* slot;
+        int task;
+        while (true) {
+            if (take(slot, task)) {
+                solve(*slot, task);
+                slot->done[task] = true;
+                writeFinished(false);
+                readAhead(false);
+                continue;
+            }
+            if (readAhead(true)) continue;
+            writeFinished(true);
+            unique_lock<mutex> lock(m);
+            changed.wait(lock, [this] { return finished() || claimed < chunks() || readable(); });
+            if (finished()) return;
+        }
+    }
+
+public:
+    BatchPipeline(PuzzleReader& reader, SolutionWriter& writer, const SolverOptions& options, SolutionCache<N>* cache,
+                  long long count_limit, OutputFormat format)
+        : reader(reader), writer(writer), options(options), cache(cache), count_limit(count_limit), format(format) {}
+
+    // solves the whole input on the given number of threads, the calling one included
+    void run(int threads) {
+        vector<thread> workers;
+        for (int w = 1; w < threads; ++w) {
+            workers.emplace_back([this] { work(); });
+        }
+        work();
+        for (thread& t : workers) {
+            t.join();
+        }
+    }
+};
+
+// microbenchmark of the 9x9 conflict kernels on boards with valid rows, like the ones the GA produces
+int benchFitness() {
+    constexpr int BOARDS = 4096;
+    default_random_engine generator;
+    vector<Board<3>> boards(BOARDS);
+    vector<const Board<3>*> pointers(BOARDS);
+    for (int k = 0; k < BOARDS; ++k) {
+        for (int i = 0; i < 9; ++i) {
+            iota(boards[k].cells.begin() + i * 9, boards[k].cells.begin() + i * 9 + 9, 1);
+            shuffle(boards[k].cells.begin() + i * 9, boards[k].cells.begin() + i * 9 + 9, generator);
+        }
+        pointers[k] = &boards[k];
+    }
+
+    vector<pair<const char*, ConflictKernel<3>>> kernels = {{"scalar", conflictsScalar<3>}};
+#ifdef FITNESS_SIMD
+    if (__builtin_cpu_supports("ssse3")) kernels.push_back({"sse", conflictsSseBatch});
+    if (__builtin_cpu_supports("avx2")) kernels.push_back({"avx2", conflictsAvx2});
+#endif
+
+    vector<int> expected(BOARDS), conflicts(BOARDS);
+    conflictsScalar<3>(pointers.data(), expected.data(), BOARDS);
+    for (auto& [name, kernel] : kernels) {
+        kernel(pointers.data(), conflicts.data(), BOARDS);
+        if (conflicts != expected) {
+            cout << name << ": results differ from the scalar kernel" << endl;
+            return 1;
+        }
+        long long evaluated = 0;
+        auto start = chrono::steady_clock::now();
+        double seconds = 0;
+        while (seconds < 0.5) {
+            kernel(pointers.data(), conflicts.data(), BOARDS);
+            evaluated += BOARDS;
+            seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        }
+        cout << name << ": " << (long long)(evaluated / seconds) << " boards/s" << endl;
+    }
+    return 0;
+}
+
+// corpus of the benchmark suite: puzzles of the given side with min_givens..max_givens given cells, one per line
+struct BenchBucket {
+    const char* name;
+    const char* file;
+    int side;
+    int min_givens;
+    int max_givens;
+};
+
+constexpr BenchBucket BENCH_BUCKETS[] = {
+    {"minimal17", "minimal17.txt", 9, 17, 17},
+    {"hard", "hard.txt", 9, 20, 25},
+    {"medium", "medium.txt", 9, 26, 29},
+    {"easy", "easy.txt", 9, 30, 40},
+    {"16x16", "16x16.txt", 16, 115, 135},
+    {"25x25", "25x25.txt", 25, 305, 330},
+};
+
+
+// nearest-rank percentile of sorted values
+template <class T>
+T percentile(const vector<T>& sorted, int p) {
+    size_t rank = (sorted.size() * p + 99) / 100;
+    return sorted[max<size_t>(rank, 1) - 1];
+}
+
+// mean, percentiles and maximum of one metric as a JSON object
+template <class T>
+void printDistribution(const char* name, vector<T> values) {
+    sort(values.begin(), values.end());
+    cout << "\"" << name << "\": {\"mean\": " << accumulate(values.begin(), values.end(), 0.0) / values.size()
+         << ", \"p50\": " << percentile(values, 50) << ", \"p95\": " << percentile(values, 95)
+         << ", \"p99\": " << percentile(values, 99) << ", \"max\": " << values.back() << "}";
+}
+
+// solves every bundled corpus of this size, puzzle k of a bucket with the seed options.seed + k so runs are
+// reproducible, and prints latency, generations, restarts, search nodes and peak memory per bucket as JSON;
+// with a time limit the latency includes the puzzles that timed out
+template <int N>
+int benchSolver(SolverOptions options, const string& dir, int limit) {
+    unsigned seed = options.seed;
+    cout << fixed << setprecision(3);
+    cout << "{\n  \"solver\": \"" << SOLVER_NAMES[options.kind] << "\",\n"
+         << "  \"size\": " << SIDE<N> << ",\n"
+         << "  \"seed\": " << seed << ",\n"
+         << "  \"islands\": " << options.islands << ",\n"
+         << "  \"buckets\": [";
+    bool first = true;
+    for (const BenchBucket& bucket : BENCH_BUCKETS) {
+        if (bucket.side != SIDE<N>) continue;
+        string path = dir + "/" + bucket.file;
+        PuzzleReader reader(path);
+        if (!reader.ok()) {
+            cerr << "cannot open " << path << endl;
+            return 1;
+        }
+        vector<Board<N>> puzzles;
+        Board<N> board;
+        ReadStatus status;
+        while ((limit == 0 || (int)puzzles.size() < limit) && (status = reader.next(board)) != INPUT_END) {
+            if (status == PUZZLE_INVALID) continue;
+            int givens = CELLS<N> - count(board.cells.begin(), board.cells.end(), 0);
+            if (givens < bucket.min_givens || givens > bucket.max_givens) {
+                cerr << path << ": puzzle " << puzzles.size() + 1 << " has " << givens << " givens" << endl;
+            }
+            puzzles.push_back(board);
+        }
+        if (puzzles.empty()) {
+            cerr << "no puzzles in " << path << endl;
+            return 1;
+        }
+
+        vector<double> latency;
+        vector<long long> generations, restarts, nodes;
+        int solved = 0, timed_out = 0;
+        for (size_t k = 0; k < puzzles.size(); ++k) {
+            options.seed = seed + k;
+            SolveStats stats;
+            Board<N> solution;
+            auto start = chrono::steady_clock::now();
+            SolveStatus status = solvePuzzle(puzzles[k], options, solution, &stats);
+            latency.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+            solved += status == SOLVED && validSolution(puzzles[k], solution);
+            timed_out += status == TIMED_OUT;
+            generations.push_back(stats.generations);
+            restarts.push_back(stats.restarts);
+            nodes.push_back(stats.nodes);
+        }
+
+        // ru_maxrss is in KiB on Linux and only grows, so it is the peak of the run so far
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        cout << (first ? "" : ",") << "\n    {\"name\": \"" << bucket.name << "\", \"givens\": [" << bucket.min_givens
+             << ", " << bucket.max_givens << "], \"puzzles\": " << puzzles.size() << ", \"solved\": " << solved
+             << ", \"timed_out\": " << timed_out << ",\n     ";
+        printDistribution("latency_ms", latency);
+        cout << ",\n     ";
+        printDistribution("generations", generations);
+        cout << ",\n     ";
+        printDistribution("restarts", restarts);
+        cout << ",\n     ";
+        printDistribution("nodes", nodes);
+        cout << ",\n     \"peak_rss_kib\": " << usage.ru_maxrss << "}";
+        first = false;
+    }
+    cout << "\n  ]\n}" << endl;
+    return 0;
+}
+
+// microbenchmark of reading puzzles and of reading plus preprocessing them, on the bench corpora of this size
+template <int N>
+int benchPreprocess(const string& dir) {
+    string text;
+    for (const BenchBucket& bucket : BENCH_BUCKETS) {
+        if (bucket.side != SIDE<N>) continue;
+        string path = dir + "/" + bucket.file;
+        ifstream file(path, ios::binary);
+        if (!file) {
+            cerr << "cannot open " << path << endl;
+            return 1;
+        }
+        text.append(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    }
+
+    // the parser on the whole text, then the preprocessing on the parsed boards
+    vector<Board<N>> boards;
+    long long parsed = 0;
+    auto start = chrono::steady_clock::now();
+    double parse_seconds = 0;
+    while (parse_seconds < 0.5) {
+        PuzzleReader reader(text.data(), text.size());
+        boards.clear();
+        Board<N> board;
+        while (reader.next(board) == PUZZLE_READ) {
+            boards.push_back(board);
+        }
+        parsed += boards.size();
+        parse_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+
+    long long preprocessed = 0, unknown = 0;
+    start = chrono::steady_clock::now();
+    double preprocess_seconds = 0;
+    while (preprocess_seconds < 0.5) {
+        for (const Board<N>& board : boards) {
+            SudokuCandidates<N> candidates(board);
+            candidates.propagate();
+            unknown += candidates.unknown_numbers;
+        }
+        preprocessed += boards.size();
+        preprocess_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+
+    // the canonical form the solution cache is keyed by
+    long long canonicalized = 0, incomplete = 0;
+    vector<uint64_t> forms(boards.size());
+    start = chrono::steady_clock::now();
+    double canonical_seconds = 0;
+    while (canonical_seconds < 0.5) {
+        incomplete = 0;
+        for (size_t k = 0; k < boards.size(); ++k) {
+            Transform<N> transform;
+            Canonicalizer<N> canonicalizer;
+            forms[k] = boardHash(canonicalizer.canonicalize(boards[k], transform));
+            incomplete += !canonicalizer.complete();
+        }
+        canonicalized += boards.size();
+        canonical_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+
+    double parse_us = parse_seconds * 1e6 / parsed, preprocess_us = preprocess_seconds * 1e6 / preprocessed;
+    cout << "parse: " << parse_us << " us per puzzle" << endl;
+    cout << "preprocess: " << preprocess_us << " us per puzzle, "
+         << (double)unknown / preprocessed << " empty cells left" << endl;
+    cout << "parse + preprocess: " << (long long)(1e6 / (parse_us + preprocess_us)) << " puzzles/s" << endl;
+    sort(forms.begin(), forms.end());
+    cout << "canonical form: " << canonical_seconds * 1e6 / canonicalized << " us per puzzle, "
+         << unique(forms.begin(), forms.end()) - forms.begin() << " distinct forms among " << boards.size() << " puzzles, "
+         << incomplete << " keyed as they are" << endl;
     return 0;
 }
+
+// load generator for the service: the puzzles of the input file are sent round-robin over the given number
+// of connections, each waiting for an answer before its next request, and the throughput and the latency
+// seen by the client are printed as JSON along with the solve time the service reported
+int loadTest(const string& path, const string& input_path, int connections, int requests) {
+    int input = input_path == "-" ? 0 : open(input_path.c_str(), O_RDONLY);
+    if (input < 0) {
+        cerr << "cannot open " << input_path << endl;
+        return 1;
+    }
+    vector<string> puzzles;
+    {
+        LineReader lines(input);
+        string line;
+        while (lines.next(line)) {
+            if (line.find_first_not_of(" \t") != string::npos) puzzles.push_back(line + '\n');
+        }
+        if (input > 0) close(input);
+    }
+    if (puzzles.empty()) {
+        cerr << "no puzzles in " << input_path << endl;
+        return 1;
+    }
+    if (requests <= 0) requests = puzzles.size();
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        cerr << "socket path too long: " << path << endl;
+        return 1;
+    }
+    copy(path.begin(), path.end(), address.sun_path);
+
+    atomic<int> next{0};
+    atomic<int> solved{0}, failed{0};
+    vector<vector<double>> latency(connections), solve_time(connections);
+    auto client = [&](int c) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, (sockaddr*)&address, sizeof(address)) < 0) {
+            cerr << "cannot connect to " << path << ": " << strerror(errno) << endl;
+            if (fd >= 0) close(fd);
+            failed += 1;
+            return;
+        }
+        LineReader answers(fd);
+        string line;
+        for (int k; (k = next++) < requests;) {
+            const string& puzzle = puzzles[k % puzzles.size()];
+            auto start = chrono::steady_clock::now();
+            if (!writeAll(fd, puzzle.data(), puzzle.size()) || !answers.next(line)) {
+                failed += 1;
+                break;
+            }
+            latency[c].push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+            solved += line.compare(0, 7, "solved ") == 0;
+            // status, board, waiting and solving microseconds
+            size_t last = line.rfind(' ');
+            solve_time[c].push_back(atof(line.c_str() + last + 1) / 1000);
+        }
+        close(fd);
+    };
+
+    auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    for (int c = 0; c < connections; ++c) {
+        threads.emplace_back(client, c);
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    vector<double> all_latency, all_solve_time;
+    for (int c = 0; c < connections; ++c) {
+        all_latency.insert(all_latency.end(), latency[c].begin(), latency[c].end());
+        all_solve_time.insert(all_solve_time.end(), solve_time[c].begin(), solve_time[c].end());
+    }
+    if (all_latency.empty()) {
+        cerr << "no answers from " << path << endl;
+        return 1;
+    }
+    cout << fixed << setprecision(3);
+    cout << "{\n  \"connections\": " << connections << ",\n  \"requests\": " << all_latency.size()
+         << ",\n  \"solved\": " << solved << ",\n  \"failed\": " << failed << ",\n  \"seconds\": " << seconds
+         << ",\n  \"requests_per_second\": " << all_latency.size() / seconds << ",\n  ";
+    printDistribution("latency_ms", all_latency);
+    cout << ",\n  ";
+    printDistribution("solve_ms", all_solve_time);
+    cout << "\n}" << endl;
+    return failed ? 1 : 0;
+}
+
+// what main() was asked to do besides the solver settings
+struct Command {
+    SolverOptions options;
+    bool batch = false;
+    int threads = 1;
+    string input_path;
+    string output_path = "-";
+    OutputFormat format = DEFAULT_FORMAT;
+    bool bench = false;
+    bool bench_preprocess = false;
+    string bench_dir = "bench";
+    int bench_limit = 0;
+    // budget of a whole batch in seconds, 0 for none
+    double batch_time_limit = 0;
+    // entries of the solution cache, 0 for no cache, and the file it is loaded from and saved to
+    size_t cache_size = 0;
+    string cache_path;
+    // the unix socket the service listens on, "-" for stdin and stdout
+    string serve_path;
+    // counting mode: solutions are counted up to this limit instead of being printed, 0 for off
+    long long count_limit = 0;
+    // the load generator: the service's socket, its connections and requests (0 for one per input puzzle)
+    string load_path;
+    int connections = 1;
+    int requests = 0;
+};
+
+// the benchmark, a single puzzle or a batch on boards with N x N boxes
+template <int N>
+int run(Command& command) {
+    SolverOptions& options = command.options;
+    if (command.bench_preprocess) {
+        return benchPreprocess<N>(command.bench_dir);
+    }
+    // the benchmark solves each puzzle on its own, with the threads as islands of the genetic algorithm
+    if (command.bench) {
+        options.islands = command.threads;
+        return benchSolver<N>(options, command.bench_dir, command.bench_limit);
+    }
+
+    cerr << "solver: " << SOLVER_NAMES[options.kind] << endl;
+    SolutionCache<N> cache(command.cache_size);
+    SolutionCache<N>* cached = command.cache_size > 0 ? &cache : nullptr;
+    // a cache file that did not load cleanly is left as it is rather than replaced by what was kept of it
+    bool cache_loaded = true;
+    if (cached && !command.cache_path.empty()) {
+        cache_loaded = cache.load(command.cache_path);
+    }
+    auto finish = [&] {
+        if (!cached) return 0;
+        if (!command.cache_path.empty() && !cache_loaded) {
+            cerr << command.cache_path << " is not overwritten because it did not load cleanly" << endl;
+        } else if (!command.cache_path.empty() && !cache.save(command.cache_path)) {
+            cerr << "cannot write " << command.cache_path << endl;
+        }
+        cache.report(cerr);
+        return 0;
+    };
+
+    // the service answers until stdin ends, or on a socket until SIGINT or SIGTERM; a client that hangs up
+    // must not stop it
+    if (!command.serve_path.empty()) {
+        signal(SIGPIPE, SIG_IGN);
+        if (command.serve_path != "-") {
+            sigset_t signals = SolverService<N>::stopSignals();
+            pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+        }
+        if (options.time_limit <= 0) {
+            options.time_limit = SERVICE_TIME_LIMIT;
+            cerr << "time limit: " << SERVICE_TIME_LIMIT << " seconds per request" << endl;
+        }
+        SolverService<N> service(options, cached, command.threads);
+        if (command.serve_path != "-") {
+            if (service.listen(command.serve_path) != 0) return 1;
+        } else {
+            service.serve(0, 1);
+        }
+        return finish();
+    }
+
+    // a single puzzle comes from input.txt, a batch from stdin unless a file is given
+    string& input_path = command.input_path;
+    if (input_path.empty()) {
+        input_path = command.batch ? "-" : "input.txt";
+    }
+    PuzzleReader reader(input_path);
+    if (!reader.ok()) {
+        cerr << "cannot open " << input_path << endl;
+        return 1;
+    }
+    SolutionWriter writer(command.output_path);
+    if (!writer.ok()) {
+        cerr << "cannot open " << command.output_path << endl;
+        return 1;
+    }
+
+    Board<N> board, solution;
+    if (!command.batch) {
+        ReadStatus status = reader.next(board);
+        if (status != PUZZLE_READ) {
+            cerr << (status == INPUT_END ? "no puzzle in " : "invalid puzzle in ") << input_path << endl;
+            return 1;
+        }
+        // a single puzzle counted on several threads has its search tree split between them
+        if (command.count_limit > 0) {
+            writer.message(countSolutions(board, options, command.count_limit, command.threads));
+            return finish();
+        }
+        // a single puzzle uses the threads as islands of the genetic algorithm
+        options.islands = command.threads;
+        SolveStats stats;
+        SolveStatus result = solveCached(board, options, solution, cached, &stats);
+        OutputFormat format = command.format == LINE_FORMAT ? LINE_FORMAT : GRID_FORMAT;
+        if (result == SOLVED) {
+            writer.write(solution, format);
+        } else if (result == UNSOLVABLE) {
+            writer.message("No solution");
+        } else if (stats.fitness < 0) {
+            writer.message("Timed out");
+        } else {
+            // the best board the genetic algorithm found
+            writer.message("Timed out, best fitness " + to_string(stats.fitness));
+            writer.write(solution, format);
+        }
+        return finish();
+    }
+
+    // batch mode: solutions are written one per line in input order; an invalid puzzle gets an "Invalid puzzle"
+    // line so the output stays in step with the input, and so does a puzzle that ran out of its own time or of
+    // the batch's: once the batch is out of time the rest time out at once
+    if (command.batch_time_limit > 0) {
+        auto budget = chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(command.batch_time_limit));
+        options.deadline = chrono::steady_clock::now() + budget;
+    }
+    OutputFormat format = command.format == GRID_FORMAT ? GRID_FORMAT : LINE_FORMAT;
+    BatchPipeline<N>(reader, writer, options, cached, command.count_limit, format).run(command.threads);
+    return finish();
+}
+
+int main(int argc, char* argv[]) {
+    Command command;
+    SolverOptions& options = command.options;
+    int size = 9;
+    for (int a = 1; a < argc; ++a) {
+        string arg = argv[a];
+        if (arg == "--solver" && a + 1 < argc) {
+            string value = argv[++a];
+            if (value == "ga") {
+                options.kind = GENETIC_SOLVER;
+            } else if (value == "hybrid") {
+                options.kind = HYBRID_SOLVER;
+            } else if (value == "dfs") {
+                options.kind = EXACT_SOLVER;
+            } else {
+                cerr << "unknown solver: " << value << " (expected ga, hybrid or dfs)" << endl;
+                return 1;
+            }
+        } else if (arg == "--size" && a + 1 < argc) {
+            size = atoi(argv[++a]);
+            if (size != 9 && size != 16 && size != 25) {
+                cerr << "--size expects 9, 16 or 25" << endl;
+                return 1;
+            }
+        } else if (arg == "--bench-fitness") {
+            return benchFitness();
+        } else if (arg == "--bench-preprocess") {
+            command.bench_preprocess = true;
+        } else if (arg == "--bench") {
+            command.bench = true;
+        } else if (arg == "--bench-dir" && a + 1 < argc) {
+            command.bench_dir = argv[++a];
+        } else if (arg == "--bench-limit" && a + 1 < argc) {
+            command.bench_limit = atoi(argv[++a]);
+        } else if (arg == "--verbose" || arg == "-v") {
+            options.verbose = true;
+        } else if (arg == "--trace" && a + 1 < argc) {
+#ifdef SOLVER_TRACE
+            TRACE.path = argv[++a];
+#else
+            cerr << "--trace needs a build with -DSOLVER_TRACE" << endl;
+            return 1;
+#endif
+        } else if (arg == "--seed" && a + 1 < argc) {
+            options.seed = strtoul(argv[++a], nullptr, 10);
+        } else if (arg == "--batch") {
+            command.batch = true;
+        } else if (arg == "--input" && a + 1 < argc) {
+            command.input_path = argv[++a];
+        } else if (arg == "--output" && a + 1 < argc) {
+            command.output_path = argv[++a];
+        } else if (arg == "--format" && a + 1 < argc) {
+            string value = argv[++a];
+            if (value == "grid") {
+                command.format = GRID_FORMAT;
+            } else if (value == "line") {
+                command.format = LINE_FORMAT;
+            } else {
+                cerr << "unknown format: " << value << " (expected grid or line)" << endl;
+                return 1;
+            }
+        } else if (arg == "--threads" && a + 1 < argc) {
+            command.threads = atoi(argv[++a]);
+            if (command.threads < 1) {
+                cerr << "--threads expects a positive number" << endl;
+                return 1;
+            }
+        } else if (arg == "--checked-boards" && a + 1 < argc) {
+            options.checked_boards = strtoull(argv[++a], nullptr, 10);
+        } else if (arg == "--time-limit" && a + 1 < argc) {
+            options.time_limit = atof(argv[++a]);
+        } else if (arg == "--max-generations" && a + 1 < argc) {
+            options.generation_limit = atoll(argv[++a]);
+        } else if (arg == "--batch-time-limit" && a + 1 < argc) {
+            command.batch_time_limit = atof(argv[++a]);
+        } else if (arg == "--cache" && a + 1 < argc) {
+            command.cache_size = strtoull(argv[++a], nullptr, 10);
+        } else if (arg == "--cache-file" && a + 1 < argc) {
+            command.cache_path = argv[++a];
+        } else if (arg == "--count" && a + 1 < argc) {
+            command.count_limit = atoll(argv[++a]);
+        } else if (arg == "--unique") {
+            command.count_limit = 2;
+        } else if (arg == "--serve" && a + 1 < argc) {
+            command.serve_path = argv[++a];
+        } else if (arg == "--load-test" && a + 1 < argc) {
+            command.load_path = argv[++a];
+        } else if (arg == "--connections" && a + 1 < argc) {
+            command.connections = atoi(argv[++a]);
+            if (command.connections < 1) {
+                cerr << "--connections expects a positive number" << endl;
+                return 1;
+            }
+        } else if (arg == "--requests" && a + 1 < argc) {
+            command.requests = atoi(argv[++a]);
+        } else {
+            cerr << "usage: " << argv[0] << " [--solver ga|hybrid|dfs] [--size 9|16|25] [--batch] [--threads N] [--input FILE|-]"
+                 << " [--output FILE|-] [--format grid|line]"
+                 << " [--time-limit SECONDS] [--max-generations N] [--batch-time-limit SECONDS] [--cache N [--cache-file FILE]]"
+                 << " [--count LIMIT|--unique] [--serve SOCKET|-] [--load-test SOCKET [--connections N] [--requests N]]"
+                 << " [--verbose] [--trace FILE] [--checked-boards N] [--seed N] [--bench-fitness] [--bench-preprocess]"
+                 << " [--bench [--bench-dir DIR] [--bench-limit N]]" << endl;
+            return 1;
+        }
+    }
+
+    if (!command.load_path.empty()) {
+        signal(SIGPIPE, SIG_IGN);
+        return loadTest(command.load_path, command.input_path.empty() ? "-" : command.input_path,
+                        command.connections, command.requests);
+    }
+    if (!command.cache_path.empty() && command.cache_size == 0) {
+        command.cache_size = SOLUTION_CACHE_CAPACITY;
+    }
+    switch (size) {
+        case 16: return run<4>(command);
+        case 25: return run<5>(command);
+        default: return run<3>(command);
+    }
+}